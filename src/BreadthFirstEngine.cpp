@@ -0,0 +1,129 @@
+#include "BreadthFirstEngine.h"
+#include <algorithm>
+
+
+
+namespace ClassProject {
+
+
+///////////////////////////////////////////////////////////////////////////////
+// One top-level operation: expand top-down, reduce bottom-up
+// Sub-calls always have their top variable below the calling request, so a
+// level's queue is complete once expansion reaches it, and all its children
+// are reduced before it.
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::BreadthFirstEngine::run(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h) {
+    reset();
+    this->op = op;
+    levels.resize(manager.levelVars.size());
+
+    Edge root = request(f, g, h);
+    if (root.request == NO_REQUEST) return root.value;
+
+    try {
+        for (VarIndex level = 0; level < levels.size(); ++level) {
+            std::vector<size_t> &queue = levels[level];
+            std::sort(queue.begin(), queue.end(), [this](size_t a, size_t b) {
+                const Request &x = requests[a], &y = requests[b];
+                if (x.f != y.f) return x.f < y.f;
+                return x.g != y.g ? x.g < y.g : x.h < y.h;
+            });
+            for (size_t r : queue) expand(r, level);
+        }
+
+        for (VarIndex level = static_cast<VarIndex>(levels.size()); level-- > 0;) {
+            for (size_t r : levels[level]) {
+                Request &q = requests[r];
+                q.result = manager.findOrCreateNode(resolve(q.high), resolve(q.low), level);
+                manager.computedTable.insert(op, q.f, q.g, q.h, q.result);
+            }
+        }
+    } catch (...) {
+        // nodes created so far are garbage, the requests are dropped
+        reset();
+        throw;
+    }
+    return resolve(root);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: answer a sub-call, or queue it as a request at its top level
+///////////////////////////////////////////////////////////////////////////////
+Manager::BreadthFirstEngine::Edge Manager::BreadthFirstEngine::request(BDD_ID f, BDD_ID g, BDD_ID h) {
+    BDD_ID flags = 0, result = 0;
+    CacheOp reduced = op;           // only quantification, which never runs here, rewrites it
+    if (manager.reduceApply(reduced, f, g, h, flags, result)) return {result, NO_REQUEST};
+    if (manager.computedTable.lookup(op, f, g, h, result)) return {result ^ flags, NO_REQUEST};
+
+    // a cofactor call is split at the level of f, everything else at the top
+    // variable of the operands
+    VarIndex level = (op == OP_COFACTOR_TRUE || op == OP_COFACTOR_FALSE)
+                     ? manager.node(f).level : manager.getTopVar(f, g, h);
+    return {flags, findOrAddRequest(f, g, h, level)};
+}
+
+size_t Manager::BreadthFirstEngine::findOrAddRequest(BDD_ID f, BDD_ID g, BDD_ID h, VarIndex level) {
+    if (2 * (requests.size() + 1) > index.size()) growIndex();
+    const size_t mask = index.size() - 1;
+    for (size_t slot = Manager::hashNode(Manager::hashNode(f, g), h) & mask;; slot = (slot + 1) & mask) {
+        size_t r = index[slot];
+        if (r == NO_REQUEST) {
+            r = requests.size();
+            requests.push_back({f, g, h, {0, NO_REQUEST}, {0, NO_REQUEST}, 0});
+            levels[level].push_back(r);
+            index[slot] = r;
+            return r;
+        }
+        const Request &q = requests[r];
+        if (q.f == f && q.g == g && q.h == h) return r;
+    }
+}
+
+void Manager::BreadthFirstEngine::growIndex() {
+    index.assign(std::max(MIN_INDEX_SIZE, 2 * index.size()), NO_REQUEST);
+    const size_t mask = index.size() - 1;
+    for (size_t r = 0; r < requests.size(); ++r) {
+        const Request &q = requests[r];
+        size_t slot = Manager::hashNode(Manager::hashNode(q.f, q.g), q.h) & mask;
+        while (index[slot] != NO_REQUEST) slot = (slot + 1) & mask;
+        index[slot] = r;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: split a request into its high and low sub-calls
+///////////////////////////////////////////////////////////////////////////////
+void Manager::BreadthFirstEngine::expand(size_t r, VarIndex level) {
+    // copies: queuing sub-calls may move the requests
+    const BDD_ID f = requests[r].f, g = requests[r].g, h = requests[r].h;
+    BDD_ID highF, lowF, highG, lowG, highH, lowH;
+    manager.splitApply(op, f, g, h, level, highF, highG, highH, lowF, lowG, lowH);
+    Edge high = request(highF, highG, highH);
+    Edge low = request(lowF, lowG, lowH);
+    requests[r].high = high;
+    requests[r].low = low;
+}
+
+BDD_ID Manager::BreadthFirstEngine::resolve(const Edge &edge) const {
+    if (edge.request == NO_REQUEST) return edge.value;
+    return requests[edge.request].result ^ edge.value;
+}
+
+void Manager::BreadthFirstEngine::reset() {
+    if (8 * requests.size() < index.size()) {
+        // a small run after a large one: only touch the slots in use
+        const size_t mask = index.size() - 1;
+        for (size_t r = 0; r < requests.size(); ++r) {
+            const Request &q = requests[r];
+            size_t slot = Manager::hashNode(Manager::hashNode(q.f, q.g), q.h) & mask;
+            while (index[slot] != r) slot = (slot + 1) & mask;
+            index[slot] = NO_REQUEST;
+        }
+    } else {
+        std::fill(index.begin(), index.end(), NO_REQUEST);
+    }
+    requests.clear();
+    for (auto &queue : levels) queue.clear();
+}
+
+}
@@ -0,0 +1,67 @@
+// Breadth-first apply for the BDD manager
+//
+
+#ifndef VDSPROJECT_BREADTHFIRSTENGINE_H
+#define VDSPROJECT_BREADTHFIRSTENGINE_H
+
+#include "Manager.h"
+#include <vector>
+
+namespace ClassProject {
+
+    /**
+     * @brief Level-by-level evaluator of one apply operation (CAL style)
+     *
+     * Instead of following one path down at a time, the operation is split
+     * into requests, one per distinct non-terminal sub-call, queued at the
+     * level of their top variable. Expansion walks the levels top-down and
+     * turns every request of a level into its two sub-calls on lower levels;
+     * a sub-call that is terminal or cached is answered at once and equal
+     * ones share a request. Reduction then walks the levels bottom-up and
+     * creates the nodes of one level after the other, so all inserts of a
+     * batch go to the same subtable. The requests of a level are visited in
+     * operand order, which turns the node reads of large BDDs into a mostly
+     * ascending sweep over the node store.
+     *
+     * Memory for the requests grows with the number of sub-calls of the
+     * operation and is kept for the next one.
+     */
+    class Manager::BreadthFirstEngine {
+    public:
+        explicit BreadthFirstEngine(Manager &manager) : manager(manager) {}
+
+        BDD_ID run(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h);
+
+    private:
+        static constexpr size_t NO_REQUEST = ~static_cast<size_t>(0);
+        static constexpr size_t MIN_INDEX_SIZE = 1 << 10;
+
+        /// Result of a sub-call: known, or that of a request complemented by flags
+        struct Edge {
+            BDD_ID value;
+            size_t request;
+        };
+
+        struct Request {
+            BDD_ID f, g, h;                 // normalized operands, the cache key
+            Edge high, low;
+            BDD_ID result;
+        };
+
+        Manager &manager;
+        CacheOp op = OP_ITE;
+        std::vector<Request> requests;
+        std::vector<std::vector<size_t>> levels;    // level -> requests queued there
+        std::vector<size_t> index;                  // open addressing over requests, NO_REQUEST marks a free slot
+
+        Edge request(BDD_ID f, BDD_ID g, BDD_ID h);
+        size_t findOrAddRequest(BDD_ID f, BDD_ID g, BDD_ID h, VarIndex level);
+        void growIndex();
+        void expand(size_t r, VarIndex level);
+        BDD_ID resolve(const Edge &edge) const;
+        void reset();
+    };
+
+}
+
+#endif
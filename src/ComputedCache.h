@@ -0,0 +1,259 @@
+// Direct-mapped, lossy computed table for the BDD manager
+//
+
+#ifndef VDSPROJECT_COMPUTEDCACHE_H
+#define VDSPROJECT_COMPUTEDCACHE_H
+
+#include "ManagerInterface.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+namespace ClassProject {
+
+    /**
+     * @brief Fixed-size computed table in the style of CUDD/Sylvan
+     *
+     * The table holds a power-of-two number of entries, every key maps to
+     * exactly one slot and a colliding insert simply overwrites that slot.
+     * Memory use is therefore bounded and no allocation happens per entry;
+     * losing an entry only costs a recomputation. Keys carry an operation tag
+     * so different operations share one table; operands and results must be
+     * BDD_IDs so that garbage collection can check and remap them. With
+     * auto-resize enabled the table doubles (up to a limit) whenever the hit
+     * rate observed over the last window of inserts shows the cache is worth
+     * growing. The old entries are then moved over a few per insert, and a
+     * lookup that misses checks the old slot until it was moved.
+     *
+     * lookupShared() and insertShared() may be called from several threads
+     * at once. Every entry carries a sequence number that is odd while a
+     * writer fills it; a reader that sees it change misses, and a writer that
+     * finds the entry busy drops its insert. They neither count statistics
+     * nor resize the table.
+     */
+    class ComputedCache {
+    public:
+        static constexpr BDD_ID EMPTY = ~static_cast<BDD_ID>(0);
+
+        explicit ComputedCache(size_t entries) { resize(entries); }
+
+        bool lookup(uint32_t op, BDD_ID f, BDD_ID g, BDD_ID h, BDD_ID &result) {
+            ++lookups;
+            ++windowLookups;
+            const size_t key = hash(op, f, g, h);
+            const Entry *entry = &table[key & mask];
+            if (!entry->matches(op, f, g, h)) {
+                if (!old || (key & oldMask) < drained) return false;
+                entry = &old[key & oldMask];
+                if (!entry->matches(op, f, g, h)) return false;
+            }
+            ++hits;
+            ++windowHits;
+            result = entry->result.load(std::memory_order_relaxed);
+            return true;
+        }
+
+        void insert(uint32_t op, BDD_ID f, BDD_ID g, BDD_ID h, BDD_ID result) {
+            table[slot(op, f, g, h)].set(op, f, g, h, result);
+            if (old) drain(DRAIN_STEP);
+            if (autoResize && ++windowInserts >= capacity) checkResize();
+        }
+
+        bool lookupShared(uint32_t op, BDD_ID f, BDD_ID g, BDD_ID h, BDD_ID &result) const {
+            const Entry &entry = table[slot(op, f, g, h)];
+            uint32_t seq = entry.seq.load(std::memory_order_acquire);
+            if (seq & 1) return false;
+            bool hit = entry.matches(op, f, g, h);
+            BDD_ID value = entry.result.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (!hit || entry.seq.load(std::memory_order_relaxed) != seq) return false;
+            result = value;
+            return true;
+        }
+
+        void insertShared(uint32_t op, BDD_ID f, BDD_ID g, BDD_ID h, BDD_ID result) {
+            Entry &entry = table[slot(op, f, g, h)];
+            uint32_t seq = entry.seq.load(std::memory_order_relaxed);
+            if ((seq & 1) || !entry.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) return;
+            entry.set(op, f, g, h, result);
+            entry.seq.store(seq + 2, std::memory_order_release);
+        }
+
+        /// Resizes to the next power of two >= entries, keeping what fits
+        void resize(size_t entries) {
+            drain(oldCapacity);
+            size_t newCapacity = 1;
+            while (newCapacity < entries) newCapacity <<= 1;
+
+            std::unique_ptr<Entry[]> previous(new Entry[newCapacity]);
+            previous.swap(table);
+            size_t previousCapacity = capacity;
+            capacity = newCapacity;
+            mask = capacity - 1;
+            for (size_t i = 0; i < previousCapacity; ++i) {
+                const Entry &entry = previous[i];
+                if (entry.empty()) continue;
+                uint32_t op = entry.op.load(std::memory_order_relaxed);
+                BDD_ID f = entry.f.load(std::memory_order_relaxed);
+                BDD_ID g = entry.g.load(std::memory_order_relaxed);
+                BDD_ID h = entry.h.load(std::memory_order_relaxed);
+                table[slot(op, f, g, h)].set(op, f, g, h, entry.result.load(std::memory_order_relaxed));
+            }
+            resetWindow();
+        }
+
+        void setAutoResize(bool enable, size_t maxEntries, double minHitRate = 0.3) {
+            autoResize = enable;
+            maxCapacity = maxEntries;
+            resizeHitRate = minHitRate;
+            resetWindow();
+        }
+
+        void clear() {
+            old.reset();
+            oldCapacity = oldMask = drained = 0;
+            for (size_t i = 0; i < capacity; ++i) table[i].clear();
+        }
+
+        /// Drops every entry for which dead(id) holds for one of its IDs
+        template<typename Pred>
+        void invalidate(Pred dead) {
+            drain(oldCapacity);
+            for (size_t i = 0; i < capacity; ++i) {
+                Entry &entry = table[i];
+                if (entry.empty()) continue;
+                if (dead(entry.f.load(std::memory_order_relaxed)) || dead(entry.g.load(std::memory_order_relaxed)) ||
+                    dead(entry.h.load(std::memory_order_relaxed)) || dead(entry.result.load(std::memory_order_relaxed))) {
+                    entry.clear();
+                }
+            }
+        }
+
+        /// Rewrites every entry through map(id); entries must all be live
+        template<typename Map>
+        void remap(Map map) {
+            drain(oldCapacity);
+            std::unique_ptr<Entry[]> previous(new Entry[capacity]);
+            previous.swap(table);
+            for (size_t i = 0; i < capacity; ++i) {
+                const Entry &entry = previous[i];
+                if (entry.empty()) continue;
+                uint32_t op = entry.op.load(std::memory_order_relaxed);
+                BDD_ID f = map(entry.f.load(std::memory_order_relaxed));
+                BDD_ID g = map(entry.g.load(std::memory_order_relaxed));
+                BDD_ID h = map(entry.h.load(std::memory_order_relaxed));
+                table[slot(op, f, g, h)].set(op, f, g, h, map(entry.result.load(std::memory_order_relaxed)));
+            }
+        }
+
+        size_t size() const { return capacity; }
+
+        size_t lookups = 0;   ///< total number of lookups
+        size_t hits = 0;      ///< total number of successful lookups
+
+    private:
+        /// Fields are atomics so that shared readers and writers never race;
+        /// every access is relaxed, which costs nothing on common hardware.
+        struct Entry {
+            std::atomic<BDD_ID> f{EMPTY}, g{EMPTY}, h{EMPTY}, result{EMPTY};
+            std::atomic<uint32_t> op{0};
+            std::atomic<uint32_t> seq{0};
+
+            bool empty() const { return f.load(std::memory_order_relaxed) == EMPTY; }
+
+            bool matches(uint32_t o, BDD_ID x, BDD_ID y, BDD_ID z) const {
+                return f.load(std::memory_order_relaxed) == x && g.load(std::memory_order_relaxed) == y &&
+                       h.load(std::memory_order_relaxed) == z && op.load(std::memory_order_relaxed) == o;
+            }
+
+            void set(uint32_t o, BDD_ID x, BDD_ID y, BDD_ID z, BDD_ID r) {
+                f.store(x, std::memory_order_relaxed);
+                g.store(y, std::memory_order_relaxed);
+                h.store(z, std::memory_order_relaxed);
+                result.store(r, std::memory_order_relaxed);
+                op.store(o, std::memory_order_relaxed);
+            }
+
+            void clear() { set(0, EMPTY, EMPTY, EMPTY, EMPTY); }
+        };
+
+        static constexpr size_t DRAIN_STEP = 4;    // old entries moved per insert while growing
+
+        std::unique_ptr<Entry[]> table;
+        size_t capacity = 0;
+        size_t mask = 0;
+        std::unique_ptr<Entry[]> old;               // entries before the last growth, null once moved
+        size_t oldCapacity = 0, oldMask = 0;
+        size_t drained = 0;                         // old slots already moved
+
+        bool autoResize = false;
+        size_t maxCapacity = 0;
+        double resizeHitRate = 0.3;
+        size_t windowLookups = 0, windowHits = 0, windowInserts = 0;
+
+        size_t slot(uint32_t op, BDD_ID f, BDD_ID g, BDD_ID h) const {
+            return hash(op, f, g, h) & mask;
+        }
+
+        static size_t hash(uint32_t op, BDD_ID f, BDD_ID g, BDD_ID h) {
+            uint64_t x = (static_cast<uint64_t>(f) + op) * 0x9E3779B97F4A7C15ull;
+            x ^= static_cast<uint64_t>(g) * 0xC2B2AE3D27D4EB4Full;
+            x ^= static_cast<uint64_t>(h) * 0x165667B19E3779F9ull;
+            x ^= x >> 32;
+            x *= 0xD6E8FEB86659FD93ull;
+            x ^= x >> 32;
+            return static_cast<size_t>(x);
+        }
+
+        void resetWindow() {
+            windowLookups = windowHits = windowInserts = 0;
+        }
+
+        void checkResize() {
+            bool worthIt = windowLookups > 0 &&
+                           static_cast<double>(windowHits) >= resizeHitRate * static_cast<double>(windowLookups);
+            if (worthIt && capacity < maxCapacity) {
+                grow();
+            } else {
+                resetWindow();
+            }
+        }
+
+        /// Doubles the table and leaves the old entries to drain()
+        void grow() {
+            drain(oldCapacity);
+            old = std::move(table);
+            oldCapacity = capacity;
+            oldMask = mask;
+            drained = 0;
+            capacity <<= 1;
+            mask = capacity - 1;
+            table.reset(new Entry[capacity]);
+            resetWindow();
+        }
+
+        /// Moves up to count old entries; newer entries in their slot win
+        void drain(size_t count) {
+            if (!old) return;
+            const size_t end = std::min(oldCapacity, drained + count);
+            for (; drained < end; ++drained) {
+                const Entry &entry = old[drained];
+                if (entry.empty()) continue;
+                uint32_t op = entry.op.load(std::memory_order_relaxed);
+                BDD_ID f = entry.f.load(std::memory_order_relaxed);
+                BDD_ID g = entry.g.load(std::memory_order_relaxed);
+                BDD_ID h = entry.h.load(std::memory_order_relaxed);
+                Entry &target = table[slot(op, f, g, h)];
+                if (target.empty()) target.set(op, f, g, h, entry.result.load(std::memory_order_relaxed));
+            }
+            if (drained == oldCapacity) {
+                old.reset();
+                oldCapacity = oldMask = drained = 0;
+            }
+        }
+    };
+
+}
+
+#endif
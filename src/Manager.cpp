@@ -1,7 +1,11 @@
 #include "Manager.h"
+#include "ParallelEngine.h"
+#include "BreadthFirstEngine.h"
 #include <fstream>
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <unordered_set>
 
 
 namespace ClassProject {
@@ -9,22 +13,54 @@ namespace ClassProject {
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Constructor: initialize unique table with False (0) and True (1)
+// Constructor: initialize unique table with the single terminal node.
+// False (0) is its regular edge, True (1) its complemented edge.
 ///////////////////////////////////////////////////////////////////////////////
 Manager::Manager() {
-    uniqueTable.clear();
-
-    // Constant nodes
-    uniqueTable.emplace_back(0, 0, 0, 0, "False");
+    // Constant node; it belongs to no level and is never hashed
+    uniqueTable.push_back(BDDNode(0, 0, TERMINAL_LEVEL));
     falseId = 0;
+    trueId = complement(falseId);
+
+    computedTable.setAutoResize(true, DEFAULT_MAX_CACHE_SIZE);
+    checkTable.setAutoResize(true, DEFAULT_MAX_CACHE_SIZE);
+    applyStack.reserve(APPLY_STACK_RESERVE);
+}
 
-    uniqueTable.emplace_back(1, 1, 1, 1, "True");
-    trueId = 1;
+Manager::~Manager() = default;
 
-    // Initialize unique-table hash index
-    uniqueIndex.clear();
-    uniqueIndex.emplace(UniqueKey{0, 0, 0}, falseId);
-    uniqueIndex.emplace(UniqueKey{1, 1, 1}, trueId);
+void Manager::setComputedCacheSize(size_t entries) {
+    ExclusiveAccess access = exclusiveAccess();
+    computedTable.resize(entries);
+}
+
+void Manager::setComputedCacheAutoResize(bool enable, size_t maxEntries, double minHitRate) {
+    ExclusiveAccess access = exclusiveAccess();
+    computedTable.setAutoResize(enable, maxEntries, minHitRate);
+}
+
+size_t Manager::computedCacheSize() const {
+    return computedTable.size();
+}
+
+size_t Manager::computedCacheLookups() const {
+    std::lock_guard<std::mutex> lock(statsLock);
+    return computedTable.lookups;
+}
+
+size_t Manager::computedCacheHits() const {
+    std::lock_guard<std::mutex> lock(statsLock);
+    return computedTable.hits;
+}
+
+size_t Manager::checkCacheLookups() const {
+    std::lock_guard<std::mutex> lock(statsLock);
+    return checkTable.lookups;
+}
+
+size_t Manager::checkCacheHits() const {
+    std::lock_guard<std::mutex> lock(statsLock);
+    return checkTable.hits;
 }
 
 
@@ -43,18 +79,18 @@ bool Manager::isConstant(BDD_ID f) {
 }
 
 bool Manager::isVariable(BDD_ID x) {
-    if (isConstant(x)) return false;
-    const BDDNode &n = uniqueTable[x];
-    return (n.topVar == x && n.high == trueId && n.low == falseId);
+    if (isConstant(x) || isComplemented(x)) return false;
+    return varNodes[levelVars[node(x).level]] == x;
 }
 
 void Manager::debugPrintNode(BDD_ID id) {
-    const auto &n = uniqueTable[id];
+    const auto &n = node(id);
     std::cout << "id=" << id
-              << " topVar=" << n.topVar
+              << (isComplemented(id) ? " (complement)" : "")
+              << " topVar=" << topVar(id)
               << " high=" << n.high
               << " low=" << n.low
-              << " label=" << n.label << "\n";
+              << " label=" << getTopVarName(id) << "\n";
 }
 
 
@@ -62,13 +98,22 @@ void Manager::debugPrintNode(BDD_ID id) {
 // Variable creation
 ///////////////////////////////////////////////////////////////////////////////
 BDD_ID Manager::createVar(const std::string &label) {
-    BDD_ID id = uniqueTable.size();
-    // first create the node
-    uniqueTable.emplace_back(id, trueId, falseId, id, label);
-    // then register it in the unique index
-    UniqueKey key{id, trueId, falseId};
-    uniqueIndex.emplace(key, id);
-    return id;
+    ExclusiveAccess access = exclusiveAccess();
+    // readers index the variable tables without a lock, they must not move
+    if (threadSafe && varNodes.size() == varNodes.capacity()) {
+        throw std::runtime_error("Variable capacity of the thread-safe mode exhausted");
+    }
+    // A new variable goes below all existing ones
+    VarIndex var = static_cast<VarIndex>(varNodes.size());
+    varLabels.push_back(label);
+    varNodes.push_back(falseId);
+    varLevels.push_back(var);
+    levelVars.push_back(var);
+    subtables.emplace_back();
+    subtables.back().reset(MIN_SUBTABLE_BUCKETS);
+    // the variable node is the function ite(var, 1, 0)
+    varNodes[var] = findOrCreateNode(trueId, falseId, varLevels[var]);
+    return varNodes[var];
 }
 
 
@@ -76,204 +121,961 @@ BDD_ID Manager::createVar(const std::string &label) {
 // Top variable of a node
 ///////////////////////////////////////////////////////////////////////////////
 BDD_ID Manager::topVar(BDD_ID f) {
-    return uniqueTable[f].topVar;
+    if (isConstant(f)) return f;
+    return varNodes[levelVars[node(f).level]];
 }
 
 std::string Manager::getTopVarName(const BDD_ID &root) {
-    BDD_ID top = topVar(root);
-    return uniqueTable[top].label;
+    if (root == trueId) return "True";
+    if (root == falseId) return "False";
+    return varLabels[levelVars[node(root).level]];
 }
 
 size_t Manager::uniqueTableSize() {
-    return uniqueTable.size();
+    return uniqueTable.size() - freeNodes.size();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// Helper: choose smallest top variable of i, t, e
+// Helper: choose the top level of i, t, e
+// (the terminal's level sorts below every real variable)
 ///////////////////////////////////////////////////////////////////////////////
-BDD_ID Manager::getTopVar(BDD_ID i, BDD_ID t, BDD_ID e) {
-    BDD_ID result = topVar(i);
-    if (!isConstant(t) && topVar(t) < result) result = topVar(t);
-    if (!isConstant(e) && topVar(e) < result) result = topVar(e);
-    return result;
+VarIndex Manager::getTopVar(BDD_ID i, BDD_ID t, BDD_ID e) const {
+    return std::min({node(i).level, node(t).level, node(e).level});
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// Helper: unique table lookup 
+// Helper: unique table hashing
+// Every level has its own subtable. Buckets hold the index of the first node
+// of a chain, the nodes themselves carry the key and the link to the next
+// node of the chain.
 ///////////////////////////////////////////////////////////////////////////////
-BDD_ID Manager::findOrCreateNode(BDD_ID high, BDD_ID low, BDD_ID topVariable) {
-    if (high == low) return high;
+size_t Manager::hashNode(BDD_ID high, BDD_ID low) {
+    uint64_t x = static_cast<uint64_t>(high) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ low) * 0x94D049BB133111EBull;
+    return static_cast<size_t>(x ^ (x >> 31));
+}
 
-    UniqueKey key{topVariable, high, low};
-    auto it = uniqueIndex.find(key);
-    if (it != uniqueIndex.end()) {
-        return it->second;
+void Manager::insertIntoSubtable(size_t idx) {
+    BDDNode &n = uniqueTable[idx];
+    Subtable &table = subtables[n.level];
+    std::atomic<NodeRef> &head = table.head(n.high, n.low);
+    n.next = head.load(std::memory_order_relaxed);
+    head.store(static_cast<NodeRef>(idx), std::memory_order_relaxed);
+    ++table.keys;
+}
+
+void Manager::removeFromSubtable(size_t idx) {
+    BDDNode &n = uniqueTable[idx];
+    Subtable &table = subtables[n.level];
+    // a node on an old chain is found there, else it is on its new chain
+    std::atomic<NodeRef> *old = table.oldHead(n.high, n.low);
+    std::atomic<NodeRef> &head = old != nullptr ? *old : table.head(n.high, n.low);
+    size_t prev = head.load(std::memory_order_relaxed);
+    if (prev == idx) {
+        head.store(n.next, std::memory_order_relaxed);
+    } else {
+        while (prev != 0 && uniqueTable[prev].next != idx) prev = uniqueTable[prev].next;
+        if (prev == 0) {
+            std::atomic<NodeRef> &newHead = table.head(n.high, n.low);
+            prev = newHead.load(std::memory_order_relaxed);
+            if (prev == idx) {
+                newHead.store(n.next, std::memory_order_relaxed);
+                --table.keys;
+                return;
+            }
+            while (uniqueTable[prev].next != idx) prev = uniqueTable[prev].next;
+        }
+        uniqueTable[prev].next = n.next;
+    }
+    --table.keys;
+}
+
+void Manager::resizeSubtable(VarIndex level, size_t bucketCount) {
+    finishRehash(level);
+    Subtable &table = subtables[level];
+    std::unique_ptr<std::atomic<NodeRef>[]> old = std::move(table.buckets);
+    size_t oldCount = table.bucketCount;
+    table.reset(bucketCount);
+    for (size_t b = 0; b < oldCount; ++b) {
+        for (size_t idx = old[b].load(std::memory_order_relaxed); idx != 0;) {
+            size_t next = uniqueTable[idx].next;
+            insertIntoSubtable(idx);
+            idx = next;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: incremental growth
+// The old bucket array is kept and drained a few buckets at a time; until a
+// bucket is drained, lookups check its chain after the new one.
+///////////////////////////////////////////////////////////////////////////////
+void Manager::growSubtable(VarIndex level) {
+    Subtable &table = subtables[level];
+    if (rehashStep == 0 || threadSafe) {
+        resizeSubtable(level, table.bucketCount << 1);
+        return;
+    }
+    finishRehash(level);
+    size_t keys = table.keys;
+    std::unique_ptr<std::atomic<NodeRef>[]> old = std::move(table.buckets);
+    size_t oldCount = table.bucketCount;
+    table.reset(oldCount << 1);
+    table.keys = keys;
+    table.oldBuckets = std::move(old);
+    table.oldBucketCount = oldCount;
+}
+
+void Manager::drainSubtable(VarIndex level, size_t buckets) {
+    Subtable &table = subtables[level];
+    size_t end = std::min(table.oldBucketCount, table.drained + buckets);
+    for (; table.drained < end; ++table.drained) {
+        std::atomic<NodeRef> &bucket = table.oldBuckets[table.drained];
+        for (size_t idx = bucket.load(std::memory_order_relaxed); idx != 0;) {
+            BDDNode &n = uniqueTable[idx];
+            size_t next = n.next;
+            std::atomic<NodeRef> &head = table.head(n.high, n.low);
+            n.next = head.load(std::memory_order_relaxed);
+            head.store(static_cast<NodeRef>(idx), std::memory_order_relaxed);
+            idx = next;
+        }
+        bucket.store(0, std::memory_order_relaxed);
     }
+    if (table.drained == table.oldBucketCount) {
+        table.oldBuckets.reset();
+        table.oldBucketCount = table.drained = 0;
+    }
+}
+
+void Manager::finishRehash(VarIndex level) {
+    if (subtables[level].oldBuckets) drainSubtable(level, subtables[level].oldBucketCount);
+}
+
+void Manager::finishRehashes() {
+    for (VarIndex level = 0; level < subtables.size(); ++level) finishRehash(level);
+}
 
-    BDD_ID newId = uniqueTable.size();
-    uniqueTable.emplace_back(newId, high, low, topVariable, "");
-    uniqueIndex.emplace(key, newId);
-    return newId;
+void Manager::setUniqueTableGrowth(double maxLoadFactor, size_t maxChainLength, size_t rehashStep) {
+    ExclusiveAccess access = exclusiveAccess();
+    if (maxLoadFactor <= 0) throw std::invalid_argument("Load factor must be positive");
+    this->maxLoadFactor = maxLoadFactor;
+    this->maxChainLength = maxChainLength;
+    this->rehashStep = rehashStep;
+    if (rehashStep == 0) finishRehashes();
 }
 
+/// Smallest power of two from minBuckets up that holds keys within the load factor
+size_t Manager::bucketsFor(size_t keys, size_t minBuckets) const {
+    size_t bucketCount = minBuckets;
+    while (static_cast<double>(keys) > maxLoadFactor * static_cast<double>(bucketCount)) bucketCount <<= 1;
+    return bucketCount;
+}
+
+void Manager::rebuildSubtables() {
+    std::vector<size_t> keys(subtables.size(), 0);
+    for (size_t i = 1; i < uniqueTable.size(); ++i) {
+        if (uniqueTable[i].level != FREE_LEVEL) ++keys[uniqueTable[i].level];
+    }
+    for (size_t level = 0; level < subtables.size(); ++level) {
+        subtables[level].reset(bucketsFor(keys[level], MIN_SUBTABLE_BUCKETS));
+    }
+    for (size_t i = 1; i < uniqueTable.size(); ++i) {
+        if (uniqueTable[i].level != FREE_LEVEL) insertIntoSubtable(i);
+    }
+}
 
 ///////////////////////////////////////////////////////////////////////////////
-// ITE operator: if i then t else e
+// Helper: unique table lookup 
+// A complemented low edge is normalized away: (v, h, ~l) is stored as the
+// complement of (v, ~h, l), so f and ~f always share the same node.
 ///////////////////////////////////////////////////////////////////////////////
-BDD_ID Manager::ite(BDD_ID i, BDD_ID t, BDD_ID e) {
-    // Terminal cases (unchanged)
-    if (i == trueId)  return t;
-    if (i == falseId) return e;
-    if (t == trueId && e == falseId) return i;
-    if (t == e) return t;
+BDD_ID Manager::findOrCreateNode(BDD_ID high, BDD_ID low, VarIndex level) {
+    if (high == low) return high;
 
-    
+    if (isComplemented(low)) {
+        return complement(findOrCreateNode(complement(high), complement(low), level));
+    }
 
+    Subtable &table = subtables[level];
+    std::atomic<NodeRef> &head = table.head(high, low);
+    size_t chain = 0;
+    for (size_t idx = head.load(std::memory_order_relaxed); idx != 0; idx = uniqueTable[idx].next, ++chain) {
+        const BDDNode &n = uniqueTable[idx];
+        if (n.high == high && n.low == low) {
+            return idx << 1;
+        }
+    }
+    if (std::atomic<NodeRef> *old = table.oldHead(high, low)) {
+        for (size_t idx = old->load(std::memory_order_relaxed); idx != 0; idx = uniqueTable[idx].next, ++chain) {
+            const BDDNode &n = uniqueTable[idx];
+            if (n.high == high && n.low == low) {
+                return idx << 1;
+            }
+        }
+    }
 
-    //  memoization lookup
-    IteKey key{i, t, e};
-    auto it = computedTable.find(key);
-    if (it != computedTable.end()) {
-        return it->second;
+    if (refCounts.empty()) {
+        // sifting is never interrupted, it would leave the levels half swapped
+        if (nodeLimit != 0 && uniqueTableSize() >= nodeLimit) {
+            throw std::runtime_error("Node limit exceeded");
+        }
+        if (abortFlag != nullptr && abortFlag->load(std::memory_order_relaxed)) {
+            throw std::runtime_error("BDD operation aborted");
+        }
     }
 
-    // Choose top variable (you already do this correctly)
-    BDD_ID x = topVar(i);
-    if (!isConstant(t) && topVar(t) < x) x = topVar(t);
-    if (!isConstant(e) && topVar(e) < x) x = topVar(e);
+    size_t idx;
+    if (!freeNodes.empty()) {
+        // reuse a slot released by the garbage collector
+        idx = freeNodes.back();
+        freeNodes.pop_back();
+        uniqueTable[idx] = BDDNode(high, low, level);
+    } else {
+        if (uniqueTable.size() >= MAX_NODES) {
+            throw std::runtime_error("Unique table exceeds the node reference width");
+        }
+        idx = uniqueTable.allocate();
+        uniqueTable[idx] = BDDNode(high, low, level);
+    }
+    uniqueTable[idx].next = head.load(std::memory_order_relaxed);
+    head.store(static_cast<NodeRef>(idx), std::memory_order_relaxed);
+    ++table.keys;
+
+    if (!refCounts.empty()) {
+        // created while sifting: the new node holds references to its children
+        if (refCounts.size() <= idx) refCounts.resize(uniqueTable.size(), 0);
+        refCounts[idx] = 0;
+        ++refCounts[high >> 1];
+        ++refCounts[low >> 1];
+    }
 
-    // Cofactors
-    BDD_ID iHigh = coFactorTrue(i, x);
-    BDD_ID iLow  = coFactorFalse(i, x);
-    BDD_ID tHigh = coFactorTrue(t, x);
-    BDD_ID tLow  = coFactorFalse(t, x);
-    BDD_ID eHigh = coFactorTrue(e, x);
-    BDD_ID eLow  = coFactorFalse(e, x);
+    if (table.oldBuckets) drainSubtable(level, rehashStep);
+    const double load = static_cast<double>(table.keys) / static_cast<double>(table.bucketCount);
+    if (load > maxLoadFactor || (chain > maxChainLength && 2 * load >= maxLoadFactor)) growSubtable(level);
+    return idx << 1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Apply engine
+// ite, the binary kernels and the general cofactor share one iterative
+// evaluator. A call that is neither terminal nor cached becomes a frame on
+// applyStack; it is expanded into its high and low sub-calls, which use the
+// same operation, and finished once both results are back. The depth of a
+// call is thus bounded by memory instead of the thread's call stack, and the
+// stack is kept between calls so the hot loop does not allocate.
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::apply(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h) {
+    if (threadSafe) return concurrentApply(op, f, g, h);
+
+    if (applyStack.empty() && autoReorder && uniqueTableSize() >= reorderThreshold) {
+        reorder({f, g, h});
+    }
+    if (applyStack.empty() && parallel && parallel->threadCount() > 1) {
+        return parallel->run(op, f, g, h);
+    }
+    if (applyStack.empty() && breadthFirst && op <= OP_XOR) {     // operations that only build nodes
+        return breadthFirst->run(op, f, g, h);
+    }
+    return applyDepthFirst(op, f, g, h);
+}
 
-    // Recursive calls
-    BDD_ID high = ite(iHigh, tHigh, eHigh);
-    BDD_ID low  = ite(iLow,  tLow,  eLow);
+///////////////////////////////////////////////////////////////////////////////
+// Helper: the depth-first evaluator itself. Calls nested in a running call
+// come here directly: they must neither sift under its operands nor switch
+// to another engine, even before its first frame is pushed.
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::applyDepthFirst(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h) {
+    const size_t base = applyStack.size();
+    BDD_ID result = 0;
+    bool returning = false;         // result holds the value of the last finished call
+
+    try {
+        for (;;) {
+            if (!returning) {
+                BDD_ID flags = 0;
+                if (reduceApply(op, f, g, h, flags, result)) {
+                    returning = true;
+                } else if (opTag(op) == OP_RESTRICT && node(g).level < node(f).level) {
+                    // restrict drops a care variable above f: the care set becomes the
+                    // disjunction of its cofactors, and the call is reduced again
+                    BDD_ID highG, lowG;
+                    topCofactors(g, node(g).level, highG, lowG);
+                    g = complement(applyDepthFirst(OP_AND, complement(highG), complement(lowG), 0));
+                    f ^= flags;
+                    continue;
+                } else if (computedTable.lookup(op, f, g, h, result)) {
+                    result ^= flags;
+                    returning = true;
+                } else {
+                    ApplyFrame frame;
+                    frame.op = op;
+                    frame.f = f;
+                    frame.g = g;
+                    frame.h = h;
+                    frame.flags = flags;
+                    frame.highDone = false;
+                    frame.combine = splitApply(op, f, g, h, frame.level, f, g, h,
+                                               frame.lowF, frame.lowG, frame.lowH);
+                    applyStack.push_back(frame);
+                    continue;
+                }
+            }
+
+            if (applyStack.size() == base) return result;
+            ApplyFrame &top = applyStack.back();
+            op = top.op;                    // a sub-call may have been rewritten to another operation
+            if (!top.highDone) {
+                top.high = result;
+                top.highDone = true;
+                // the low cofactor does not matter once the disjunction is True
+                if (top.combine != COMBINE_OR || result != trueId) {
+                    f = top.lowF;
+                    g = top.lowG;
+                    h = top.lowH;
+                    returning = false;
+                    continue;
+                }
+            }
+
+            BDD_ID res;
+            if (top.combine == COMBINE_NODE) {
+                res = findOrCreateNode(top.high, result, top.level);
+            } else if (top.combine == COMBINE_OR) {
+                if (top.high == trueId || result == trueId) {
+                    res = trueId;
+                } else {
+                    // nested call above this frame, which may move the stack
+                    res = complement(applyDepthFirst(OP_AND, complement(top.high), complement(result), 0));
+                }
+            } else {
+                const BDD_ID replaced = replacement(top.op, top.g, top.h, top.level);
+                if (keepsNode(replaced, top.high, result, top.level)) {
+                    res = findOrCreateNode(top.high, result, top.level);
+                } else {
+                    res = applyDepthFirst(OP_ITE, replaced, top.high, result);    // nested as above
+                }
+            }
+            const ApplyFrame &done = applyStack.back();
+            computedTable.insert(done.op, done.f, done.g, done.h, res);
+            result = res ^ done.flags;
+            applyStack.pop_back();
+        }
+    } catch (...) {
+        applyStack.resize(base);
+        throw;
+    }
+}
 
-    BDD_ID res = findOrCreateNode(high, low, x);
+///////////////////////////////////////////////////////////////////////////////
+// Helper: terminal cases and operand normalization of one apply call
+// Returns true with the result for a terminal call; otherwise leaves the
+// normalized operands (the cache key) and the complement to apply to the
+// result.
+///////////////////////////////////////////////////////////////////////////////
+bool Manager::reduceApply(CacheOp &op, BDD_ID &f, BDD_ID &g, BDD_ID &h, BDD_ID &flags, BDD_ID &result) const {
+    switch (opTag(op)) {
+    case OP_ITE: {
+        BDD_ID &i = f, &t = g, &e = h;
+        // Terminal cases
+        if (i == trueId)  { result = t; return true; }
+        if (i == falseId) { result = e; return true; }
+
+        // Operands equal to i (or ~i) are constant under i
+        if (t == i) t = trueId;
+        else if (t == complement(i)) t = falseId;
+        if (e == i) e = falseId;
+        else if (e == complement(i)) e = trueId;
+
+        if (t == e) { result = t; return true; }
+        if (t == trueId && e == falseId) { result = i; return true; }
+        if (t == falseId && e == trueId) { result = complement(i); return true; }
+
+        // Standard triples: commutative forms put the smaller regular ID first
+        if (t == trueId) {                              // i + e
+            if (regular(e) < regular(i)) std::swap(i, e);
+        } else if (e == falseId) {                      // i * t
+            if (regular(t) < regular(i)) std::swap(i, t);
+        } else if (e == trueId) {                       // i -> t  ==  ~t -> ~i
+            if (regular(t) < regular(i)) {
+                BDD_ID old = i;
+                i = complement(t);
+                t = complement(old);
+            }
+        } else if (t == falseId) {                      // ~i * e  ==  ~e * i
+            if (regular(e) < regular(i)) {
+                BDD_ID old = i;
+                i = complement(e);
+                e = complement(old);
+            }
+        } else if (e == complement(t)) {                // i xnor t
+            if (regular(t) < regular(i)) {
+                std::swap(i, t);
+                e = complement(t);
+            }
+        }
+
+        // Complement normalization: i and t regular, the complement moves to the result
+        if (isComplemented(i)) {
+            i = complement(i);
+            std::swap(t, e);
+        }
+        if (isComplemented(t)) {
+            t = complement(t);
+            e = complement(e);
+            flags = 1;
+        }
+        return false;
+    }
+    case OP_AND:
+        if (f == falseId || g == falseId) { result = falseId; return true; }
+        if (f == trueId) { result = g; return true; }
+        if (g == trueId) { result = f; return true; }
+        if (f == g) { result = f; return true; }
+        if (f == complement(g)) { result = falseId; return true; }
+        if (g < f) std::swap(f, g);
+        return false;
+    case OP_XOR:
+        if (f == g) { result = falseId; return true; }
+        if (f == complement(g)) { result = trueId; return true; }
+        if (f == falseId) { result = g; return true; }
+        if (g == falseId) { result = f; return true; }
+        if (f == trueId) { result = complement(g); return true; }
+        if (g == trueId) { result = complement(f); return true; }
+        // Complements on either operand only complement the result
+        flags = (f ^ g) & 1;
+        f = regular(f);
+        g = regular(g);
+        if (g < f) std::swap(f, g);
+        return false;
+    case OP_COFACTOR_TRUE:
+    case OP_COFACTOR_FALSE: {
+        // g is the node of the cofactor variable
+        const BDDNode &n = node(f);
+        VarIndex x = node(g).level;
+        if (n.level == x) {                         // f = ite(x, fh, fl)
+            result = (op == OP_COFACTOR_TRUE ? n.high : n.low) ^ (f & 1);
+            return true;
+        }
+        if (n.level > x) { result = f; return true; } // x not in support of f (or f constant)
+        // Cofactoring commutes with negation, so only regular nodes are cached
+        flags = f & 1;
+        f = regular(f);
+        return false;
+    }
+    case OP_EXISTS:
+        // g is the cube; quantifying does not commute with negation
+        if (regular(f) == falseId) { result = f; return true; }    // a constant
+        g = skipCube(g, node(f).level);
+        if (g == trueId) { result = f; return true; }
+        return false;
+    case OP_AND_EXISTS:
+        // h is the cube; the cheaper operation takes over where it applies
+        if (f == falseId || g == falseId || f == complement(g)) { result = falseId; return true; }
+        if (f == trueId || f == g) {
+            op = OP_EXISTS;
+            f = g;
+            g = h;
+            h = 0;
+            return reduceApply(op, f, g, h, flags, result);
+        }
+        if (g == trueId) {
+            op = OP_EXISTS;
+            g = h;
+            h = 0;
+            return reduceApply(op, f, g, h, flags, result);
+        }
+        h = skipCube(h, std::min(node(f).level, node(g).level));
+        if (h == trueId) {
+            op = OP_AND;
+            h = 0;
+            return reduceApply(op, f, g, h, flags, result);
+        }
+        if (g < f) std::swap(f, g);
+        return false;
+    case OP_CONSTRAIN:
+    case OP_RESTRICT:
+        // g is the care set; where one of its branches is False only the other one
+        // matters, so both operands follow it without creating a node
+        for (;;) {
+            if (g == falseId) { result = falseId; return true; }
+            if (g == trueId || regular(f) == falseId) { result = f; return true; }
+            if (f == g) { result = trueId; return true; }
+            if (f == complement(g)) { result = falseId; return true; }
+            const VarIndex level = node(g).level;
+            if (level > node(f).level) break;
+            BDD_ID highF, lowF, highG, lowG;
+            topCofactors(g, level, highG, lowG);
+            if (highG != falseId && lowG != falseId) break;
+            topCofactors(f, level, highF, lowF);
+            f = lowG == falseId ? highF : lowF;
+            g = lowG == falseId ? highG : lowG;
+        }
+        // both commute with negation of f, so only regular nodes are cached
+        flags = f & 1;
+        f = regular(f);
+        return false;
+    case OP_COMPOSE_VAR: {
+        // g is the node of the variable, h its replacement
+        if (node(f).level > node(g).level || h == g) { result = f; return true; }
+        if (regular(h) == falseId) {
+            // a constant replacement is a cofactor
+            op = h == trueId ? OP_COFACTOR_TRUE : OP_COFACTOR_FALSE;
+            h = 0;
+            return reduceApply(op, f, g, h, flags, result);
+        }
+        // substitution commutes with negation, so only regular nodes are cached
+        flags = f & 1;
+        f = regular(f);
+        return false;
+    }
+    case OP_COMPOSE:
+        // nothing at or below f's top level is replaced; this covers the constants
+        if (node(f).level > substitutions[op >> OP_TAG_BITS].bottom) { result = f; return true; }
+        // substitution commutes with negation, so only regular nodes are cached
+        flags = f & 1;
+        f = regular(f);
+        return false;
+    case OP_DISJOINT:
+        // never reached: disjointness is walked by disjoint() with reduceDisjoint()
+        return false;
+    }
+    return false;
+}
 
-    // NEW: store in computed table
-    computedTable.emplace(key, res);
+///////////////////////////////////////////////////////////////////////////////
+// Helper: top level of a non-terminal call and the operands of its two
+// sub-calls, and how their results are combined
+///////////////////////////////////////////////////////////////////////////////
+Manager::Combine Manager::splitApply(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h, VarIndex &level,
+                                     BDD_ID &highF, BDD_ID &highG, BDD_ID &highH,
+                                     BDD_ID &lowF, BDD_ID &lowG, BDD_ID &lowH) const {
+    switch (opTag(op)) {
+    case OP_COFACTOR_TRUE:
+    case OP_COFACTOR_FALSE:
+    case OP_COMPOSE: {
+        // f is regular; a cofactor variable lies below its top variable
+        const BDDNode &n = node(f);
+        level = n.level;
+        highF = n.high;
+        lowF = n.low;
+        highG = lowG = g;
+        highH = lowH = h;
+        return opTag(op) == OP_COMPOSE ? COMBINE_ITE : COMBINE_NODE;
+    }
+    case OP_COMPOSE_VAR: {
+        // above the variable both f and its replacement are split, so that most
+        // levels end in a plain node; at the variable itself f is ite(h, high, low)
+        const VarIndex x = node(g).level;
+        level = std::min(node(f).level, node(h).level);
+        if (level >= x) {
+            const BDDNode &n = node(f);
+            level = x;
+            highF = n.high;
+            lowF = n.low;
+            highH = lowH = h;
+        } else {
+            topCofactors(f, level, highF, lowF);
+            topCofactors(h, level, highH, lowH);
+        }
+        highG = lowG = g;
+        return COMBINE_ITE;
+    }
+    case OP_EXISTS:
+    case OP_AND_EXISTS: {
+        // the cube starts at or below the level and only loses a variable there
+        const BDD_ID cube = op == OP_EXISTS ? g : h;
+        level = op == OP_EXISTS ? node(f).level : std::min(node(f).level, node(g).level);
+        const BDDNode &c = node(cube);
+        const bool quantify = c.level == level;
+        const BDD_ID rest = quantify ? static_cast<BDD_ID>(c.high) : cube;
+        topCofactors(f, level, highF, lowF);
+        if (op == OP_EXISTS) {
+            highG = lowG = rest;
+            highH = lowH = h;
+        } else {
+            topCofactors(g, level, highG, lowG);
+            highH = lowH = rest;
+        }
+        return quantify ? COMBINE_OR : COMBINE_NODE;
+    }
+    default:
+        level = getTopVar(f, g, h);
+        topCofactors(f, level, highF, lowF);
+        topCofactors(g, level, highG, lowG);
+        topCofactors(h, level, highH, lowH);
+        return COMBINE_NODE;
+    }
+}
 
-    return res;
+///////////////////////////////////////////////////////////////////////////////
+// Helpers: a substituted level is ite(replacement, high, low), which is the
+// plain node where the variable is kept and both results stay below it
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::replacement(CacheOp op, BDD_ID g, BDD_ID h, VarIndex level) const {
+    if (op == OP_COMPOSE_VAR) return level == node(g).level ? h : varNodes[levelVars[level]];
+    const std::vector<BDD_ID> &functions = substitutions[op >> OP_TAG_BITS].functions;
+    const VarIndex var = levelVars[level];
+    return var < functions.size() ? functions[var] : varNodes[var];
 }
 
+bool Manager::keepsNode(BDD_ID replaced, BDD_ID high, BDD_ID low, VarIndex level) const {
+    return replaced == varNodes[levelVars[level]] && node(high).level > level && node(low).level > level;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
-// Cofactors with respect to variable x
+// Helpers: cubes are regular chains of positive literals ending in True
 ///////////////////////////////////////////////////////////////////////////////
-BDD_ID Manager::coFactorTrue(BDD_ID f, BDD_ID x) {
-    if (isConstant(f)) return f;                  // constants unchanged
-    if (f == x) return True();                    // x|_{x=1} = 1
+BDD_ID Manager::skipCube(BDD_ID cube, VarIndex level) const {
+    while (cube != trueId && node(cube).level < level) cube = node(cube).high;
+    return cube;
+}
+
+void Manager::checkCube(BDD_ID cube) const {
+    while (cube != trueId) {
+        if (cube == falseId || isComplemented(cube) || node(cube).low != falseId) {
+            throw std::invalid_argument("Quantification cube must be a conjunction of variables");
+        }
+        cube = node(cube).high;
+    }
+}
 
-    BDD_ID v = topVar(f);
-    if (v == x) return uniqueTable[f].high;       // f = ite(x, fh, fl) → fh
-    if (v > x) return f;                          // x not in support of f
 
-    BDD_ID h = coFactorTrue(uniqueTable[f].high, x);
-    BDD_ID l = coFactorTrue(uniqueTable[f].low,  x);
-    return findOrCreateNode(h, l, v);
+///////////////////////////////////////////////////////////////////////////////
+// ITE operator: if i then t else e
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::ite(BDD_ID i, BDD_ID t, BDD_ID e) {
+    return apply(OP_ITE, i, t, e);
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Cofactors with respect to variable x
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::coFactorTrue(BDD_ID f, BDD_ID x) {
+    if (isConstant(f) || isConstant(x)) return f;     // constants unchanged
+    return coFactorVar(f, node(x).level, true);
+}
 
 BDD_ID Manager::coFactorFalse(BDD_ID f, BDD_ID x) {
-    if (isConstant(f)) return f;                  // constants unchanged
-    if (f == x) return False();                   // x|_{x=0} = 0
+    if (isConstant(f) || isConstant(x)) return f;     // constants unchanged
+    return coFactorVar(f, node(x).level, false);
+}
 
-    BDD_ID v = topVar(f);
-    if (v == x) return uniqueTable[f].low;        // f = ite(x, fh, fl) → fl
-    if (v > x) return f;                          // x not in support of f
+///////////////////////////////////////////////////////////////////////////////
+// Helper: cofactors w.r.t. the variable at level x, at or above f's top level
+// (constant time, never creates nodes)
+///////////////////////////////////////////////////////////////////////////////
+void Manager::topCofactors(BDD_ID f, VarIndex x, BDD_ID &high, BDD_ID &low) const {
+    const BDDNode &n = node(f);
+    if (n.level != x) {
+        high = low = f;
+        return;
+    }
+    high = n.high ^ (f & 1);
+    low = n.low ^ (f & 1);
+}
 
-    BDD_ID h = coFactorFalse(uniqueTable[f].high, x);
-    BDD_ID l = coFactorFalse(uniqueTable[f].low,  x);
-    return findOrCreateNode(h, l, v);
+///////////////////////////////////////////////////////////////////////////////
+// Helper: general cofactor w.r.t. the variable at level x, memoized
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::coFactorVar(BDD_ID f, VarIndex x, bool positive) {
+    return apply(positive ? OP_COFACTOR_TRUE : OP_COFACTOR_FALSE, f, varNodes[levelVars[x]], 0);
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // Cofactors ignoring which variable (just go high/low)
+// A complemented edge pushes the complement down onto both children.
 ///////////////////////////////////////////////////////////////////////////////
 BDD_ID Manager::coFactorTrue(BDD_ID f) {
     if (isConstant(f)) return f;
-    return uniqueTable[f].high;
+    return node(f).high ^ (f & 1);
 }
 
 BDD_ID Manager::coFactorFalse(BDD_ID f) {
     if (isConstant(f)) return f;
-    return uniqueTable[f].low;
+    return node(f).low ^ (f & 1);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// Boolean operations via ITE
+// Binary apply kernels
+// OR is AND under De Morgan, which costs nothing with complement edges, so
+// AND and XOR are the only two kernels. Operands are ordered by ID before
+// the cache lookup since both operations are commutative.
 ///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::applyAnd(BDD_ID f, BDD_ID g) {
+    return apply(OP_AND, f, g, 0);
+}
 
+BDD_ID Manager::applyXor(BDD_ID f, BDD_ID g) {
+    return apply(OP_XOR, f, g, 0);
+}
 
-BDD_ID Manager::or2(BDD_ID a, BDD_ID b) {
-    return ite(a, trueId, b);
+
+///////////////////////////////////////////////////////////////////////////////
+// Quantification
+// forall is the dual of exists and shares its cache entries.
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::exists(BDD_ID f, BDD_ID cube) {
+    checkCube(cube);
+    return apply(OP_EXISTS, f, cube, 0);
 }
 
-BDD_ID Manager::xor2(BDD_ID a, BDD_ID b) {
-    BDD_ID nb = neg(b);
-    BDD_ID na = neg(a);
-    BDD_ID t1 = and2(a, nb);
-    BDD_ID t2 = and2(na, b);
-    return or2(t1, t2);
+BDD_ID Manager::forall(BDD_ID f, BDD_ID cube) {
+    checkCube(cube);
+    return complement(apply(OP_EXISTS, complement(f), cube, 0));
+}
+
+BDD_ID Manager::andExists(BDD_ID f, BDD_ID g, BDD_ID cube) {
+    checkCube(cube);
+    return apply(OP_AND_EXISTS, f, g, cube);
 }
 
 
-BDD_ID Manager::neg(BDD_ID a) {
-    // 1) Constants
-    if (a == True())  return False();
-    if (a == False()) return True();
+///////////////////////////////////////////////////////////////////////////////
+// Substitution
+// permute is a special substitution and shares its entries with
+// vectorCompose. A single variable has an operation of its own, which also
+// splits on the levels of its replacement: the substitution splits only on
+// the levels of f and would redo ite(g, ...) at every level above the
+// variable.
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::compose(BDD_ID f, BDD_ID x, BDD_ID g) {
+    if (!isVariable(x)) throw std::invalid_argument("Only variables can be substituted");
+    return apply(OP_COMPOSE_VAR, f, x, g);
+}
 
-    // 2) If a is a variable (then branch 1, else branch 0), just flip its children
-    if (isVariable(a)) {
-        BDD_ID v = topVar(a);
-        return findOrCreateNode(False(), True(), v);
+BDD_ID Manager::vectorCompose(BDD_ID f, const std::map<BDD_ID, BDD_ID> &substitution) {
+    if (substitution.size() == 1) {
+        return compose(f, substitution.begin()->first, substitution.begin()->second);
     }
+    uint32_t number;
+    {
+        ExclusiveAccess access = exclusiveAccess();
+        if (!internSubstitution(substitution, number)) return f;
+    }
+    return apply(composeOp(number), f, 0, 0);
+}
+
+BDD_ID Manager::permute(BDD_ID f, const std::map<BDD_ID, BDD_ID> &permutation) {
+    for (const auto &entry : permutation) {
+        if (!isVariable(entry.second)) throw std::invalid_argument("Permutation must map variables to variables");
+    }
+    return vectorCompose(f, permutation);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: number of a substitution, registered on first use; returns false
+// if it keeps every variable
+///////////////////////////////////////////////////////////////////////////////
+bool Manager::internSubstitution(const std::map<BDD_ID, BDD_ID> &substitution, uint32_t &number) {
+    std::vector<BDD_ID> functions(varNodes);
+    for (const auto &entry : substitution) {
+        if (!isVariable(entry.first)) throw std::invalid_argument("Only variables can be substituted");
+        functions[levelVars[node(entry.first).level]] = entry.second;
+    }
+    // kept variables at the end are implied, so variables created later do not change the key
+    while (!functions.empty() && functions.back() == varNodes[functions.size() - 1]) functions.pop_back();
+    if (functions.empty()) return false;
+
+    auto it = substitutionNumbers.find(functions);
+    if (it != substitutionNumbers.end()) {
+        number = it->second;
+        return true;
+    }
+    if (substitutions.size() == MAX_SUBSTITUTIONS) throw std::length_error("Too many distinct substitutions");
+    number = static_cast<uint32_t>(substitutions.size());
+    substitutionNumbers.emplace(functions, number);
+    const VarIndex bottom = deepestReplaced(functions);
+    substitutions.push_back({std::move(functions), bottom});
+    return true;
+}
+
+VarIndex Manager::deepestReplaced(const std::vector<BDD_ID> &functions) const {
+    VarIndex bottom = 0;
+    for (VarIndex var = 0; var < functions.size(); ++var) {
+        if (functions[var] != varNodes[var]) bottom = std::max(bottom, varLevels[var]);
+    }
+    return bottom;
+}
+
 
-    // 3) For composite nodes: structurally negate by negating both children,
-    //    topVar stays the same; unique table will give canonical id.
-    BDD_ID v   = topVar(a);
-    BDD_ID ah  = uniqueTable[a].high;
-    BDD_ID al  = uniqueTable[a].low;
-    BDD_ID nh  = neg(ah);
-    BDD_ID nl  = neg(al);
-    return findOrCreateNode(nh, nl, v);
+///////////////////////////////////////////////////////////////////////////////
+// Generalized cofactors
+// Both split at the top level of f and c like ite. They differ only where
+// the care set lies above f: constrain follows c there, restrict quantifies
+// its top variable away.
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::constrain(BDD_ID f, BDD_ID c) {
+    return apply(OP_CONSTRAIN, f, c, 0);
+}
+
+BDD_ID Manager::restrict(BDD_ID f, BDD_ID c) {
+    return apply(OP_RESTRICT, f, c, 0);
+}
+
+BDD_ID Manager::minimize(BDD_ID f, BDD_ID c) {
+    const BDD_ID simplified = restrict(f, c);
+    if (simplified == f) return f;
+    return countNodes(simplified) < countNodes(f) ? simplified : f;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: number of nodes of f, the terminal included
+///////////////////////////////////////////////////////////////////////////////
+size_t Manager::countNodes(BDD_ID f) const {
+    std::unordered_set<size_t> visited;
+    std::vector<size_t> stack{f >> 1};
+    while (!stack.empty()) {
+        size_t idx = stack.back();
+        stack.pop_back();
+        if (!visited.insert(idx).second || idx == 0) continue;
+        stack.push_back(uniqueTable[idx].high >> 1);
+        stack.push_back(uniqueTable[idx].low >> 1);
+    }
+    return visited.size();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Checks
+// Implication and ite constancy are disjointness questions, which a single
+// walk answers: a pair of cofactors is pushed like an apply frame, but the
+// first overlapping pair ends the whole walk, and nothing is built.
+///////////////////////////////////////////////////////////////////////////////
+bool Manager::leq(BDD_ID f, BDD_ID g) {
+    return disjoint(f, complement(g));
+}
+
+bool Manager::isDisjoint(BDD_ID f, BDD_ID g) {
+    return disjoint(f, g);
+}
+
+BDD_ID Manager::iteConstant(BDD_ID i, BDD_ID t, BDD_ID e) {
+    // the value under one assignment is the only candidate
+    const BDD_ID value = valueAtZero(i) == trueId ? valueAtZero(t) : valueAtZero(e);
+    // ite(i, t, e) is True iff i * ~t and ~i * ~e are False, and False iff i * t and ~i * e are
+    const BDD_ID flags = value == trueId ? 1 : 0;
+    return disjoint(i, t ^ flags) && disjoint(complement(i), e ^ flags) ? value : NON_CONSTANT;
+}
+
+bool Manager::disjoint(BDD_ID f, BDD_ID g) {
+    std::shared_lock<std::shared_mutex> lock(tableLock, std::defer_lock);
+    if (threadSafe) lock.lock();
+    auto remember = [this](BDD_ID f, BDD_ID g, bool answer) {
+        if (threadSafe) checkTable.insertShared(OP_DISJOINT, f, g, 0, answer ? trueId : falseId);
+        else checkTable.insert(OP_DISJOINT, f, g, 0, answer ? trueId : falseId);
+    };
+
+    std::vector<CheckFrame> stack;
+    bool result = true;
+    for (;;) {
+        if (!reduceDisjoint(f, g, result)) {
+            BDD_ID cached;
+            if (threadSafe ? checkTable.lookupShared(OP_DISJOINT, f, g, 0, cached)
+                           : checkTable.lookup(OP_DISJOINT, f, g, 0, cached)) {
+                result = cached == trueId;
+            } else {
+                CheckFrame frame{f, g, 0, 0, false};
+                const VarIndex level = std::min(node(f).level, node(g).level);
+                BDD_ID highF, highG;
+                topCofactors(frame.f, level, highF, frame.lowF);
+                topCofactors(frame.g, level, highG, frame.lowG);
+                stack.push_back(frame);
+                f = highF;
+                g = highG;
+                continue;
+            }
+        }
+
+        for (;;) {
+            if (!result) {
+                // the overlap lies below every pending pair
+                for (const CheckFrame &frame : stack) remember(frame.f, frame.g, false);
+                return false;
+            }
+            if (stack.empty()) return true;
+            CheckFrame &top = stack.back();
+            if (!top.highDone) {
+                top.highDone = true;
+                f = top.lowF;
+                g = top.lowG;
+                break;
+            }
+            remember(top.f, top.g, true);
+            stack.pop_back();
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: terminal cases of the disjointness walk; otherwise orders the
+// operands, as f * g is commutative
+///////////////////////////////////////////////////////////////////////////////
+bool Manager::reduceDisjoint(BDD_ID &f, BDD_ID &g, bool &result) const {
+    if (f == falseId || g == falseId || f == complement(g)) { result = true; return true; }
+    // the other operand is not False here
+    if (f == trueId || g == trueId || f == g) { result = false; return true; }
+    if (g < f) std::swap(f, g);
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: value of f when every variable is False
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::valueAtZero(BDD_ID f) const {
+    while (regular(f) != falseId) f = node(f).low ^ (f & 1);
+    return f;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Boolean operations
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::or2(BDD_ID a, BDD_ID b) {
+    return complement(applyAnd(complement(a), complement(b)));
+}
+
+BDD_ID Manager::xor2(BDD_ID a, BDD_ID b) {
+    return applyXor(a, b);
+}
+
+
+BDD_ID Manager::neg(BDD_ID a) {
+    // With complement edges negation is just flipping the tag bit
+    return complement(a);
 }
 
 
 BDD_ID Manager::and2(BDD_ID a, BDD_ID b) {
-    computedTable.clear();
-    return ite(a, b, falseId);
+    return applyAnd(a, b);
 }
 
 BDD_ID Manager::nand2(BDD_ID a, BDD_ID b) {
-    return neg(and2(a, b));
+    return complement(applyAnd(a, b));
 }
 
 BDD_ID Manager::nor2(BDD_ID a, BDD_ID b) {
-    return neg(or2(a, b));
+    return applyAnd(complement(a), complement(b));
 }
 
 BDD_ID Manager::xnor2(BDD_ID a, BDD_ID b) {
-    return neg(xor2(a, b));
+    return complement(applyXor(a, b));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // Traversal: collect nodes and variables reachable from root
 ///////////////////////////////////////////////////////////////////////////////
 void Manager::findNodes(const BDD_ID &root, std::set<BDD_ID> &nodes_of_root) {
-    if (nodes_of_root.find(root) != nodes_of_root.end()) return;
-    nodes_of_root.insert(root);
-    if (isConstant(root)) return;
-    findNodes(uniqueTable[root].high, nodes_of_root);
-    findNodes(uniqueTable[root].low, nodes_of_root);
+    std::vector<BDD_ID> stack{root};
+    while (!stack.empty()) {
+        BDD_ID f = stack.back();
+        stack.pop_back();
+        if (!nodes_of_root.insert(f).second || isConstant(f)) continue;
+        stack.push_back(coFactorFalse(f));
+        stack.push_back(coFactorTrue(f));
+    }
 }
 
 void Manager::findVars(const BDD_ID &root, std::set<BDD_ID> &vars_of_root) {
@@ -289,6 +1091,450 @@ void Manager::findVars(const BDD_ID &root, std::set<BDD_ID> &vars_of_root) {
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Garbage collection: mark from the roots, sweep everything else
+///////////////////////////////////////////////////////////////////////////////
+void Manager::registerRoot(BDD_ID f) {
+    if (isConstant(f)) return;
+    std::unique_lock<std::mutex> lock(rootLock, std::defer_lock);
+    if (threadSafe) lock.lock();
+    ++rootRefs[f >> 1];
+}
+
+void Manager::unregisterRoot(BDD_ID f) {
+    std::unique_lock<std::mutex> lock(rootLock, std::defer_lock);
+    if (threadSafe) lock.lock();
+    auto it = rootRefs.find(f >> 1);
+    if (it == rootRefs.end()) return;
+    if (--it->second == 0) rootRefs.erase(it);
+}
+
+std::vector<char> Manager::markLiveNodes(const std::vector<BDD_ID> &roots) {
+    std::vector<char> live(uniqueTable.size(), 0);
+    std::vector<size_t> stack;
+
+    live[0] = 1;
+    // variables are permanent
+    for (BDD_ID var : varNodes) stack.push_back(var >> 1);
+    for (const auto &root : rootRefs) stack.push_back(root.first);
+    for (BDD_ID root : roots) stack.push_back(root >> 1);
+    for (const Substitution &substitution : substitutions) {
+        for (BDD_ID function : substitution.functions) stack.push_back(function >> 1);
+    }
+
+    while (!stack.empty()) {
+        size_t idx = stack.back();
+        stack.pop_back();
+        if (live[idx]) continue;
+        live[idx] = 1;
+        stack.push_back(uniqueTable[idx].high >> 1);
+        stack.push_back(uniqueTable[idx].low >> 1);
+    }
+    return live;
+}
+
+void Manager::purgeComputedTable(const std::vector<char> &live) {
+    computedTable.invalidate([&live](BDD_ID f) { return !live[f >> 1]; });
+    checkTable.invalidate([&live](BDD_ID f) { return !live[f >> 1]; });
+}
+
+size_t Manager::collectGarbage() {
+    return collectGarbage({});
+}
+
+size_t Manager::collectGarbage(const std::vector<BDD_ID> &roots) {
+    ExclusiveAccess access = exclusiveAccess();
+    return sweepGarbage(roots);
+}
+
+size_t Manager::sweepGarbage(const std::vector<BDD_ID> &roots) {
+    if (threadSafe) recountSlots();
+    std::vector<char> live = markLiveNodes(roots);
+
+    size_t freed = 0;
+    for (size_t i = 1; i < uniqueTable.size(); ++i) {
+        BDDNode &n = uniqueTable[i];
+        if (live[i] || n.level == FREE_LEVEL) continue;
+        removeFromSubtable(i);
+        n.level = FREE_LEVEL;
+        freeNodes.push_back(i);
+        ++freed;
+    }
+    purgeComputedTable(live);
+    return freed;
+}
+
+IdRemap Manager::collectGarbageAndCompact(const std::vector<BDD_ID> &roots) {
+    ExclusiveAccess access = exclusiveAccess();
+    std::vector<char> live = markLiveNodes(roots);
+    purgeComputedTable(live);
+
+    // Number the live nodes children first, in old index order otherwise.
+    // Without reordering children already precede their parents and the
+    // relative order is kept; reordering rewrites nodes in place, after
+    // which this restores the order.
+    const BDD_ID unnumbered = ~static_cast<BDD_ID>(0);
+    IdRemap remap;
+    remap.newIndex.assign(uniqueTable.size(), unnumbered);
+    size_t next = 0;
+    std::vector<size_t> stack;
+    for (size_t i = 0; i < uniqueTable.size(); ++i) {
+        if (!live[i] || remap.newIndex[i] != unnumbered) continue;
+        stack.push_back(i);
+        while (!stack.empty()) {
+            const BDDNode &n = uniqueTable[stack.back()];
+            if (stack.back() != 0) {
+                if (remap.newIndex[n.high >> 1] == unnumbered) { stack.push_back(n.high >> 1); continue; }
+                if (remap.newIndex[n.low >> 1] == unnumbered) { stack.push_back(n.low >> 1); continue; }
+            }
+            remap.newIndex[stack.back()] = next++;
+            stack.pop_back();
+        }
+    }
+
+    NodeStore<BDDNode> compacted(BDDNode(0, 0, FREE_LEVEL));
+    for (size_t k = 0; k < next; ++k) compacted.allocate();
+    for (size_t i = 0; i < uniqueTable.size(); ++i) {
+        if (!live[i]) continue;
+        BDDNode n = uniqueTable[i];
+        n.high = static_cast<NodeRef>(remap(n.high));
+        n.low = static_cast<NodeRef>(remap(n.low));
+        compacted[remap.newIndex[i]] = n;
+    }
+    uniqueTable.swap(compacted);
+    freeNodes.clear();
+    for (BDD_ID &var : varNodes) var = remap(var);
+    rebuildSubtables();
+
+    computedTable.remap([&remap](BDD_ID f) { return remap(f); });
+    checkTable.remap([&remap](BDD_ID f) { return remap(f); });
+
+    std::unordered_map<size_t, size_t> remappedRoots;
+    for (const auto &root : rootRefs) {
+        remappedRoots.emplace(remap.newIndex[root.first], root.second);
+    }
+    rootRefs.swap(remappedRoots);
+
+    substitutionNumbers.clear();
+    for (uint32_t number = 0; number < substitutions.size(); ++number) {
+        for (BDD_ID &function : substitutions[number].functions) function = remap(function);
+        substitutionNumbers.emplace(substitutions[number].functions, number);
+    }
+
+    return remap;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Resource limits, checked whenever a node has to be created
+///////////////////////////////////////////////////////////////////////////////
+void Manager::setNodeLimit(size_t maxNodes) {
+    ExclusiveAccess access = exclusiveAccess();
+    nodeLimit = maxNodes;
+}
+
+void Manager::setAbortFlag(const std::atomic<bool> *flag) {
+    ExclusiveAccess access = exclusiveAccess();
+    abortFlag = flag;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Parallel apply, implemented in ParallelEngine.cpp
+///////////////////////////////////////////////////////////////////////////////
+void Manager::setThreadCount(size_t threads) {
+    ExclusiveAccess access = exclusiveAccess();
+    parallel.reset();
+    // thread-safe mode keeps an engine for its client threads
+    if (threads > 1 || threadSafe) parallel.reset(new ParallelEngine(*this, threads));
+}
+
+size_t Manager::getThreadCount() const {
+    return parallel ? parallel->threadCount() : 1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Breadth-first apply, implemented in BreadthFirstEngine.cpp
+///////////////////////////////////////////////////////////////////////////////
+void Manager::setBreadthFirst(bool enable) {
+    ExclusiveAccess access = exclusiveAccess();
+    if (!enable) breadthFirst.reset();
+    else if (!breadthFirst) breadthFirst.reset(new BreadthFirstEngine(*this));
+}
+
+bool Manager::isBreadthFirst() const {
+    return breadthFirst != nullptr;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Thread-safe mode
+// Client operations do not maintain the per-level key counts or the free
+// list; both are recounted from the node store before anything relies on
+// them.
+///////////////////////////////////////////////////////////////////////////////
+void Manager::setThreadSafe(bool enable, size_t maxVariables) {
+    if (enable) {
+        size_t capacity = std::max(maxVariables, varNodes.size());
+        varNodes.reserve(capacity);
+        varLabels.reserve(capacity);
+        varLevels.reserve(capacity);
+        levelVars.reserve(capacity);
+        subtables.reserve(capacity);
+        if (!parallel) parallel.reset(new ParallelEngine(*this, 1));
+        // client threads only know the new buckets
+        finishRehashes();
+        threadSafe = true;
+    } else {
+        threadSafe = false;
+        recountSlots();
+    }
+}
+
+bool Manager::isThreadSafe() const {
+    return threadSafe;
+}
+
+Manager::ExclusiveAccess Manager::exclusiveAccess() {
+    ExclusiveAccess access;
+    if (threadSafe) {
+        access.tables = std::unique_lock<std::shared_mutex>(tableLock);
+        access.roots = std::unique_lock<std::mutex>(rootLock);
+    }
+    return access;
+}
+
+void Manager::recountSlots() {
+    for (Subtable &table : subtables) table.keys = 0;
+    freeNodes.clear();
+    for (size_t i = 1; i < uniqueTable.size(); ++i) {
+        VarIndex level = uniqueTable[i].level;
+        if (level == FREE_LEVEL) freeNodes.push_back(i);
+        else ++subtables[level].keys;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Dynamic reordering: adjacent level swaps and sifting
+// While sifting every node counts its parents plus one pin per registered
+// root, explicit root or variable, so a node that loses its last reference
+// is freed at once and the node count stays exact.
+///////////////////////////////////////////////////////////////////////////////
+size_t Manager::getLevel(BDD_ID x) {
+    if (isConstant(x)) return levelVars.size();
+    return node(x).level;
+}
+
+std::vector<std::string> Manager::getVariableOrder() const {
+    std::shared_lock<std::shared_mutex> lock(tableLock, std::defer_lock);
+    if (threadSafe) lock.lock();
+    std::vector<std::string> order;
+    order.reserve(levelVars.size());
+    for (VarIndex var : levelVars) order.push_back(varLabels[var]);
+    return order;
+}
+
+void Manager::exportVariableOrder(const std::string &filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open variable order file " + filepath);
+    }
+    file << "# variable order, top level first\n";
+    for (const std::string &label : getVariableOrder()) file << label << "\n";
+}
+
+void Manager::setAutoReorder(bool enable, size_t firstThreshold) {
+    ExclusiveAccess access = exclusiveAccess();
+    autoReorder = enable;
+    reorderThreshold = firstThreshold;
+}
+
+const ReorderStats &Manager::getReorderStats() const {
+    return reorderStats;
+}
+
+size_t Manager::reorder() {
+    return reorder({});
+}
+
+size_t Manager::reorder(const std::vector<BDD_ID> &roots) {
+    ExclusiveAccess access = exclusiveAccess();
+    sweepGarbage(roots);
+    reorderStats.nodesBefore = uniqueTableSize();
+
+    refCounts.assign(uniqueTable.size(), 0);
+    refCounts[0] = 1;                               // the terminal is never released
+    for (size_t i = 1; i < uniqueTable.size(); ++i) {
+        const BDDNode &n = uniqueTable[i];
+        if (n.level == FREE_LEVEL) continue;
+        ++refCounts[n.high >> 1];
+        ++refCounts[n.low >> 1];
+    }
+    for (BDD_ID var : varNodes) ++refCounts[var >> 1];
+    for (const auto &root : rootRefs) refCounts[root.first] += static_cast<uint32_t>(root.second);
+    for (BDD_ID root : roots) ++refCounts[root >> 1];
+    for (const Substitution &substitution : substitutions) {
+        for (BDD_ID function : substitution.functions) ++refCounts[function >> 1];
+    }
+
+    // Sift the variables with the most nodes first
+    std::vector<VarIndex> vars(varNodes.size());
+    for (VarIndex var = 0; var < vars.size(); ++var) vars[var] = var;
+    std::stable_sort(vars.begin(), vars.end(), [this](VarIndex a, VarIndex b) {
+        return subtables[varLevels[a]].keys > subtables[varLevels[b]].keys;
+    });
+    for (VarIndex var : vars) siftVariable(var);
+
+    refCounts.clear();
+    // freed slots may have been reused, so cached results can no longer be trusted
+    computedTable.clear();
+    checkTable.clear();
+    for (Substitution &substitution : substitutions) substitution.bottom = deepestReplaced(substitution.functions);
+
+    ++reorderStats.runs;
+    reorderStats.nodesAfter = uniqueTableSize();
+    reorderThreshold = std::max(REORDER_MIN_NODES, 2 * reorderStats.nodesAfter);
+    return reorderStats.nodesAfter;
+}
+
+void Manager::releaseNode(size_t idx) {
+    if (--refCounts[idx] != 0) return;
+
+    std::vector<size_t> stack{idx};
+    while (!stack.empty()) {
+        size_t i = stack.back();
+        stack.pop_back();
+        BDDNode &n = uniqueTable[i];
+        removeFromSubtable(i);
+        n.level = FREE_LEVEL;
+        freeNodes.push_back(i);
+        if (--refCounts[n.high >> 1] == 0) stack.push_back(n.high >> 1);
+        if (--refCounts[n.low >> 1] == 0) stack.push_back(n.low >> 1);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: exchange the variables at level and level + 1
+// With x above y, a node F = ite(x, F1, F0) that depends on y is rewritten in
+// place into ite(y, ite(x, F11, F01), ite(x, F10, F00)), so its ID and its
+// function stay the same. x-nodes not depending on y and all y-nodes only
+// change their level.
+///////////////////////////////////////////////////////////////////////////////
+void Manager::swapAdjacentLevels(VarIndex level) {
+    const VarIndex upper = level, lower = level + 1;
+
+    // Take both levels out of their subtables
+    finishRehash(upper);
+    finishRehash(lower);
+    std::vector<size_t> upperNodes, lowerNodes;
+    for (VarIndex l : {upper, lower}) {
+        std::vector<size_t> &nodes = l == upper ? upperNodes : lowerNodes;
+        Subtable &table = subtables[l];
+        for (size_t b = 0; b < table.bucketCount; ++b) {
+            for (size_t idx = table.buckets[b].load(std::memory_order_relaxed); idx != 0;
+                 idx = uniqueTable[idx].next) {
+                nodes.push_back(idx);
+            }
+            table.buckets[b].store(0, std::memory_order_relaxed);
+        }
+        table.keys = 0;
+    }
+    // each bucket array follows the nodes of its variable
+    std::swap(subtables[upper], subtables[lower]);
+    std::swap(levelVars[upper], levelVars[lower]);
+    varLevels[levelVars[upper]] = upper;
+    varLevels[levelVars[lower]] = lower;
+
+    for (size_t idx : lowerNodes) {
+        uniqueTable[idx].level = upper;
+        insertIntoSubtable(idx);
+    }
+
+    std::vector<size_t> rewrite;
+    for (size_t idx : upperNodes) {
+        const BDDNode &n = uniqueTable[idx];
+        if (node(n.high).level == upper || node(n.low).level == upper) {
+            rewrite.push_back(idx);
+        } else {
+            uniqueTable[idx].level = lower;
+            insertIntoSubtable(idx);
+        }
+    }
+
+    for (size_t idx : rewrite) {
+        BDD_ID f1 = uniqueTable[idx].high, f0 = uniqueTable[idx].low;
+        BDD_ID f11, f10, f01, f00;
+        topCofactors(f1, upper, f11, f10);
+        topCofactors(f0, upper, f01, f00);
+
+        // f00 is regular, so the new low edge is as well
+        BDD_ID high = findOrCreateNode(f11, f01, lower);
+        BDD_ID low = findOrCreateNode(f10, f00, lower);
+        ++refCounts[high >> 1];
+        ++refCounts[low >> 1];
+
+        BDDNode &n = uniqueTable[idx];
+        n.high = static_cast<NodeRef>(high);
+        n.low = static_cast<NodeRef>(low);
+        n.level = upper;
+        insertIntoSubtable(idx);
+
+        releaseNode(f1 >> 1);
+        releaseNode(f0 >> 1);
+    }
+
+    for (VarIndex l : {upper, lower}) {
+        size_t bucketCount = bucketsFor(subtables[l].keys, subtables[l].bucketCount);
+        if (bucketCount != subtables[l].bucketCount) resizeSubtable(l, bucketCount);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: move one variable through all levels and leave it where the node
+// count was smallest (Rudell's sifting); the nearer end is visited first and
+// a direction is abandoned once the count grows past SIFT_MAX_GROWTH.
+///////////////////////////////////////////////////////////////////////////////
+void Manager::siftVariable(VarIndex var) {
+    const VarIndex levels = static_cast<VarIndex>(levelVars.size());
+    VarIndex level = varLevels[var];
+    size_t best = uniqueTableSize();
+    VarIndex bestLevel = level;
+
+    auto tooLarge = [&](size_t size) {
+        return static_cast<double>(size) > SIFT_MAX_GROWTH * static_cast<double>(best);
+    };
+    auto moveDown = [&]() {
+        while (level + 1 < levels) {
+            swapAdjacentLevels(level++);
+            size_t size = uniqueTableSize();
+            if (size < best) { best = size; bestLevel = level; }
+            if (tooLarge(size)) break;
+        }
+    };
+    auto moveUp = [&]() {
+        while (level > 0) {
+            swapAdjacentLevels(--level);
+            size_t size = uniqueTableSize();
+            if (size < best) { best = size; bestLevel = level; }
+            if (tooLarge(size)) break;
+        }
+    };
+
+    if (levels - 1 - level < level) {
+        moveDown();
+        moveUp();
+    } else {
+        moveUp();
+        moveDown();
+    }
+
+    while (level < bestLevel) swapAdjacentLevels(level++);
+    while (level > bestLevel) swapAdjacentLevels(--level);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Visualization: dump BDD as DOT file
 ///////////////////////////////////////////////////////////////////////////////
@@ -306,7 +1552,7 @@ void Manager::visualizeBDD(std::string filepath, BDD_ID &root) {
         } else if (node == trueId) {
             file << "  " << node << " [shape=box, label=\"1\"];\n";
         } else {
-            std::string label = uniqueTable[topVar(node)].label;
+            std::string label = getTopVarName(node);
             if (label.empty()) label = "x" + std::to_string(topVar(node));
             file << "  " << node << " [shape=ellipse, label=\"" << label << "\"];\n";
         }
@@ -314,8 +1560,8 @@ void Manager::visualizeBDD(std::string filepath, BDD_ID &root) {
 
     for (BDD_ID node : nodes) {
         if (!isConstant(node)) {
-            file << "  " << node << " -> " << uniqueTable[node].high << " [style=solid];\n";
-            file << "  " << node << " -> " << uniqueTable[node].low  << " [style=dashed];\n";
+            file << "  " << node << " -> " << coFactorTrue(node) << " [style=solid];\n";
+            file << "  " << node << " -> " << coFactorFalse(node) << " [style=dashed];\n";
         }
     }
 
@@ -7,60 +7,69 @@
 #define VDSPROJECT_MANAGER_H
 
 #include "ManagerInterface.h"
+#include "ComputedCache.h"
+#include "NodeStore.h"
 #include <vector>
 #include <string>
 #include <unordered_map>
 #include <set>
+#include <map>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 
+// Width of the references stored inside a node (32 or 64 bit), set by CMake
+#ifndef VDS_NODE_REF_BITS
+#define VDS_NODE_REF_BITS 32
+#endif
 
-namespace ClassProject {
 
-    
+namespace ClassProject {
 
-    struct UniqueKey {
-        BDD_ID topVar, high, low;
-        bool operator==(const UniqueKey& o) const {
-            return topVar == o.topVar && high == o.high && low == o.low;
-        }
-    };
+    typedef uint32_t VarIndex;      ///< Variable in creation order, or level in the current order
 
-    struct UniqueKeyHash {
-        std::size_t operator()(const UniqueKey& k) const {
-            std::size_t h1 = std::hash<BDD_ID>{}(k.topVar);
-            std::size_t h2 = std::hash<BDD_ID>{}(k.high);
-            std::size_t h3 = std::hash<BDD_ID>{}(k.low);
-            return ((h1 * 16777619u) ^ (h2 * 2166136261u)) ^ h3;
-        }
-    };
+    /**
+     * @brief Structure representing a single BDD node in the unique table
+     *
+     * BDD_IDs use complement edges: bit 0 of an ID is the complement tag and
+     * the remaining bits are the node's index in the unique table, so
+     * ID = (index << 1) | complemented. There is a single terminal node at
+     * index 0; False is its regular edge (ID 0) and True its complement (ID 1).
+     * Stored nodes are canonical: their low edge is never complemented.
+     *
+     * A node stores the level of its variable, i.e. its position in the
+     * current order, so order comparisons need no lookup; the manager maps
+     * levels to variables. Every level has its own unique subtable and the
+     * node itself is the key: hash buckets hold the index of the first node
+     * of a chain and each node links to the next one. Variable names live
+     * in a per-variable table of the manager, so a node is 16 bytes with
+     * 32-bit references and 32 bytes with 64-bit ones.
+     */
+    template<typename Ref>
+    struct BasicBDDNode {
+        Ref high;           // High successor (then branch), may be complemented
+        Ref low;            // Low successor (else branch), never complemented
+        Ref next;           // Next node index in the hash chain, 0 ends the chain
+        VarIndex level;     // Level of the top variable of this node
 
-    struct IteKey {
-        BDD_ID i, t, e;
-        bool operator==(const IteKey& other) const {
-            return i == other.i && t == other.t && e == other.e;
-        }
+        BasicBDDNode(BDD_ID high, BDD_ID low, VarIndex level)
+            : high(static_cast<Ref>(high)), low(static_cast<Ref>(low)), next(0), level(level) {}
     };
 
-    struct IteKeyHash {
-        std::size_t operator()(const IteKey& k) const {
-            std::size_t h1 = std::hash<BDD_ID>{}(k.i);
-            std::size_t h2 = std::hash<BDD_ID>{}(k.t);
-            std::size_t h3 = std::hash<BDD_ID>{}(k.e);
-            return ((h1 * 1315423911u) ^ (h2 * 2654435761u)) ^ h3;
-        }
-    };
+#if VDS_NODE_REF_BITS == 64
+    typedef uint64_t NodeRef;
+#else
+    typedef uint32_t NodeRef;
+#endif
+    typedef BasicBDDNode<NodeRef> BDDNode;
 
-    /**
-     * @brief Structure representing a single BDD node in the unique table
-     */
-    struct BDDNode {
-        BDD_ID id;          // Unique identifier for this node
-        BDD_ID high;        // High successor (then branch)
-        BDD_ID low;         // Low successor (else branch)
-        BDD_ID topVar;      // Top variable of this node
-        std::string label;  // Label/name of the variable (optional)
-
-        BDDNode(BDD_ID id, BDD_ID high, BDD_ID low, BDD_ID topVar, const std::string& label = "")
-            : id(id), high(high), low(low), topVar(topVar), label(label) {}
+    /// Node counts around the runs of dynamic reordering
+    struct ReorderStats {
+        size_t runs = 0;
+        size_t nodesBefore = 0;     ///< live nodes before the last run
+        size_t nodesAfter = 0;      ///< live nodes after the last run
     };
 
     /**
@@ -68,22 +77,334 @@ namespace ClassProject {
      */
     class Manager : public ManagerInterface {
     private:
-        std::vector<BDDNode> uniqueTable;
+        NodeStore<BDDNode> uniqueTable{BDDNode(0, 0, FREE_LEVEL)};     // slot index -> node, never moves
         BDD_ID trueId;
         BDD_ID falseId;
 
-        BDD_ID findOrCreateNode(BDD_ID high, BDD_ID low, BDD_ID topVar);
-        BDD_ID getTopVar(BDD_ID i, BDD_ID t, BDD_ID e);
-        std::unordered_map<UniqueKey, BDD_ID, UniqueKeyHash> uniqueIndex;
-        std::unordered_map<IteKey,    BDD_ID, IteKeyHash>    computedTable;
+        static BDD_ID complement(BDD_ID f)    { return f ^ 1; }
+        static BDD_ID regular(BDD_ID f)       { return f & ~static_cast<BDD_ID>(1); }
+        static bool isComplemented(BDD_ID f)  { return (f & 1) != 0; }
+        const BDDNode &node(BDD_ID f) const   { return uniqueTable[f >> 1]; }
+
+        static constexpr size_t DEFAULT_CACHE_SIZE = 1 << 16;      // initial computed-table entries
+        static constexpr size_t DEFAULT_MAX_CACHE_SIZE = 1 << 22;  // auto-resize limit
+        static constexpr VarIndex TERMINAL_LEVEL = ~static_cast<VarIndex>(0); // below every variable
+        static constexpr VarIndex FREE_LEVEL = TERMINAL_LEVEL - 1;             // level of a freed slot
+        static constexpr size_t MAX_NODES = static_cast<size_t>(~static_cast<NodeRef>(0)) >> 1;
+
+        std::vector<BDD_ID> varNodes;                           // variable index -> ID of its node
+        std::vector<std::string> varLabels;                     // variable index -> name
+        std::vector<VarIndex> varLevels;                        // variable index -> level
+        std::vector<VarIndex> levelVars;                        // level -> variable index
+
+        /// Unique subtable of one level, a power-of-two number of chain heads.
+        /// The heads are atomic so that parallel workers can publish nodes
+        /// with a compare-and-swap; serial code uses relaxed accesses.
+        /// While the subtable grows incrementally, the chains of the old
+        /// buckets not drained yet still hold nodes; new nodes always go to
+        /// the new buckets.
+        struct Subtable {
+            std::unique_ptr<std::atomic<NodeRef>[]> buckets;
+            size_t bucketCount = 0;
+            size_t keys = 0;
+            std::unique_ptr<std::atomic<NodeRef>[]> oldBuckets;    // null unless growing
+            size_t oldBucketCount = 0;
+            size_t drained = 0;                                    // old buckets already moved
+
+            void reset(size_t count) {
+                buckets.reset(new std::atomic<NodeRef>[count]);
+                for (size_t i = 0; i < count; ++i) buckets[i].store(0, std::memory_order_relaxed);
+                bucketCount = count;
+                keys = 0;
+                oldBuckets.reset();
+                oldBucketCount = drained = 0;
+            }
+            std::atomic<NodeRef> &head(BDD_ID high, BDD_ID low) {
+                return buckets[hashNode(high, low) & (bucketCount - 1)];
+            }
+            /// Old chain that may still hold (high, low), or nullptr
+            std::atomic<NodeRef> *oldHead(BDD_ID high, BDD_ID low) {
+                if (!oldBuckets) return nullptr;
+                size_t b = hashNode(high, low) & (oldBucketCount - 1);
+                return b >= drained ? &oldBuckets[b] : nullptr;
+            }
+        };
+        static constexpr size_t MIN_SUBTABLE_BUCKETS = 1 << 3;
+        std::vector<Subtable> subtables;                        // level -> subtable
+
+        // Growth policy of the subtables
+        static constexpr double DEFAULT_MAX_LOAD_FACTOR = 1.0;
+        static constexpr size_t DEFAULT_MAX_CHAIN_LENGTH = 16;
+        static constexpr size_t DEFAULT_REHASH_STEP = 4;       // old buckets moved per insert
+        double maxLoadFactor = DEFAULT_MAX_LOAD_FACTOR;
+        size_t maxChainLength = DEFAULT_MAX_CHAIN_LENGTH;
+        size_t rehashStep = DEFAULT_REHASH_STEP;
+
+        /// Operation tags of computed-table entries
+        enum CacheOp : uint32_t {
+            OP_ITE,
+            OP_COFACTOR_TRUE,       // (f, variable node, 0)
+            OP_COFACTOR_FALSE,      // (f, variable node, 0)
+            OP_AND,                 // (f, g, 0) with f <= g
+            OP_XOR,                 // (f, g, 0) with f <= g, both regular
+            OP_EXISTS,              // (f, cube, 0)
+            OP_AND_EXISTS,          // (f, g, cube) with f <= g
+            OP_CONSTRAIN,           // (f, care set, 0) with f regular
+            OP_RESTRICT,            // (f, care set, 0) with f regular, the care set not above f
+            OP_DISJOINT,            // (f, g, 0) with f <= g, in the check table; True or False
+            OP_COMPOSE_VAR,         // (f, variable node, replacement) with f regular, the replacement not constant
+            OP_COMPOSE              // (f, 0, 0) with f regular, the substitution number above OP_TAG_BITS
+        };
+        static constexpr uint32_t OP_TAG_BITS = 8;
+        static CacheOp opTag(CacheOp op)            { return static_cast<CacheOp>(op & ((1u << OP_TAG_BITS) - 1)); }
+        static CacheOp composeOp(uint32_t number)   { return static_cast<CacheOp>(OP_COMPOSE | number << OP_TAG_BITS); }
+
+        /// How a call is finished from the results of its two sub-calls
+        enum Combine : uint8_t {
+            COMBINE_NODE,           // node at the split level
+            COMBINE_OR,             // quantified level: high + low
+            COMBINE_ITE             // substituted level: ite(replacement, high, low)
+        };
+
+        /// Variable substitution of vectorCompose and permute, interned so
+        /// that equal substitutions share their computed-table entries
+        struct Substitution {
+            std::vector<BDD_ID> functions;  // variable index -> replacement, the variable itself if kept
+            VarIndex bottom;                // deepest level of a replaced variable
+        };
+        static constexpr uint32_t MAX_SUBSTITUTIONS = 1u << (32 - OP_TAG_BITS);
+        std::vector<Substitution> substitutions;                // substitution number -> substitution
+        std::map<std::vector<BDD_ID>, uint32_t> substitutionNumbers;
+
+        /// Pending call of the iterative apply engine
+        struct ApplyFrame {
+            CacheOp op;                     // operation after normalization
+            BDD_ID f, g, h;                 // normalized operands, the cache key
+            BDD_ID lowF, lowG, lowH;        // operands of the low sub-call
+            BDD_ID high;                    // result of the high sub-call
+            BDD_ID flags;                   // complement applied to the result
+            VarIndex level;
+            Combine combine;
+            bool highDone;
+        };
+        static constexpr size_t APPLY_STACK_RESERVE = 1 << 10;
+        std::vector<ApplyFrame> applyStack;                     // reused across calls
+
+        std::vector<size_t> freeNodes;                          // indices of freed slots
+        std::unordered_map<size_t, size_t> rootRefs;            // node index -> registration count
+
+        // Dynamic reordering
+        static constexpr size_t REORDER_MIN_NODES = 1 << 12;   // first automatic sifting
+        static constexpr double SIFT_MAX_GROWTH = 1.2;          // abandon a direction beyond this
+        bool autoReorder = false;
+        size_t reorderThreshold = REORDER_MIN_NODES;
+        std::vector<uint32_t> refCounts;                        // node index -> parents + pins, while sifting
+        ReorderStats reorderStats;
+
+        // Resource limits
+        size_t nodeLimit = 0;                                   // 0: unlimited
+        const std::atomic<bool> *abortFlag = nullptr;
+
+        // Parallel apply, see ParallelEngine.h
+        class ParallelEngine;
+        std::unique_ptr<ParallelEngine> parallel;
+
+        // Breadth-first apply, see BreadthFirstEngine.h
+        class BreadthFirstEngine;
+        std::unique_ptr<BreadthFirstEngine> breadthFirst;
+
+        // Thread-safe mode: operations hold tableLock shared, everything
+        // that restructures the tables holds it exclusively
+        static constexpr size_t DEFAULT_MAX_VARIABLES = 1 << 16;
+        bool threadSafe = false;
+        mutable std::shared_mutex tableLock;
+        std::mutex rootLock;                                    // rootRefs
+        mutable std::mutex statsLock;                           // computed table statistics
+        /// Locks held by a restructuring call, none outside thread-safe mode
+        struct ExclusiveAccess {
+            std::unique_lock<std::shared_mutex> tables;
+            std::unique_lock<std::mutex> roots;
+        };
+        ExclusiveAccess exclusiveAccess();
+        void recountSlots();
+        BDD_ID concurrentApply(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h);
+        size_t sweepGarbage(const std::vector<BDD_ID> &roots);
+
+        static size_t hashNode(BDD_ID high, BDD_ID low);
+        void insertIntoSubtable(size_t idx);
+        void removeFromSubtable(size_t idx);
+        void resizeSubtable(VarIndex level, size_t bucketCount);
+        size_t bucketsFor(size_t keys, size_t minBuckets) const;
+        void growSubtable(VarIndex level);
+        void drainSubtable(VarIndex level, size_t buckets);
+        void finishRehash(VarIndex level);
+        void finishRehashes();
+        void rebuildSubtables();
+        BDD_ID findOrCreateNode(BDD_ID high, BDD_ID low, VarIndex level);
+        std::vector<char> markLiveNodes(const std::vector<BDD_ID> &roots);
+        void purgeComputedTable(const std::vector<char> &live);
+        void releaseNode(size_t idx);
+        void swapAdjacentLevels(VarIndex level);
+        void siftVariable(VarIndex var);
+        VarIndex getTopVar(BDD_ID i, BDD_ID t, BDD_ID e) const;
+        void topCofactors(BDD_ID f, VarIndex x, BDD_ID &high, BDD_ID &low) const;
+        BDD_ID coFactorVar(BDD_ID f, VarIndex x, bool positive);
+        BDD_ID apply(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h);
+        BDD_ID applyDepthFirst(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h);
+        bool reduceApply(CacheOp &op, BDD_ID &f, BDD_ID &g, BDD_ID &h, BDD_ID &flags, BDD_ID &result) const;
+        Combine splitApply(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h, VarIndex &level,
+                           BDD_ID &highF, BDD_ID &highG, BDD_ID &highH, BDD_ID &lowF, BDD_ID &lowG, BDD_ID &lowH) const;
+        BDD_ID replacement(CacheOp op, BDD_ID g, BDD_ID h, VarIndex level) const;
+        bool keepsNode(BDD_ID replaced, BDD_ID high, BDD_ID low, VarIndex level) const;
+        bool internSubstitution(const std::map<BDD_ID, BDD_ID> &substitution, uint32_t &number);
+        VarIndex deepestReplaced(const std::vector<BDD_ID> &functions) const;
+        size_t countNodes(BDD_ID f) const;
+        BDD_ID skipCube(BDD_ID cube, VarIndex level) const;
+        void checkCube(BDD_ID cube) const;
+        BDD_ID applyAnd(BDD_ID f, BDD_ID g);
+        BDD_ID applyXor(BDD_ID f, BDD_ID g);
+        ComputedCache computedTable{DEFAULT_CACHE_SIZE};
+
+        // Checks that never build nodes, with their own cache
+        static constexpr size_t DEFAULT_CHECK_CACHE_SIZE = 1 << 14;
+        ComputedCache checkTable{DEFAULT_CHECK_CACHE_SIZE};
+        /// Pending pair of the disjointness walk
+        struct CheckFrame {
+            BDD_ID f, g;                    // normalized operands, the cache key
+            BDD_ID lowF, lowG;              // operands of the low pair
+            bool highDone;
+        };
+        bool disjoint(BDD_ID f, BDD_ID g);
+        bool reduceDisjoint(BDD_ID &f, BDD_ID &g, bool &result) const;
+        BDD_ID valueAtZero(BDD_ID f) const;
 
 
 
     public:
         Manager();
-        ~Manager() = default;
+        ~Manager();
         void debugPrintNode(BDD_ID id);
 
+        /**
+         * @brief Computed-table configuration
+         *
+         * The computed table is a lossy direct-mapped cache that lives across
+         * operations. Its size is rounded up to a power of two; with
+         * auto-resize it doubles up to maxEntries while the hit rate stays at
+         * or above minHitRate.
+         */
+        void setComputedCacheSize(size_t entries);
+        void setComputedCacheAutoResize(bool enable, size_t maxEntries = DEFAULT_MAX_CACHE_SIZE,
+                                        double minHitRate = 0.3);
+        size_t computedCacheSize() const;
+        size_t computedCacheLookups() const;
+        size_t computedCacheHits() const;
+        size_t checkCacheLookups() const;
+        size_t checkCacheHits() const;
+
+        /**
+         * @brief Dynamic variable reordering
+         *
+         * reorder() sifts every variable (Rudell's algorithm) to the level
+         * that minimizes the number of nodes. Nodes keep their IDs, but like
+         * garbage collection reordering frees everything not reachable from
+         * a registered root, an explicit root or a variable, and it clears
+         * the computed table. With auto-reorder the manager sifts on its own
+         * whenever the node count reaches the threshold, which starts at
+         * firstThreshold and is set to twice the result after every run; the
+         * operands of the operation being started are kept alive.
+         */
+        size_t reorder();
+        size_t reorder(const std::vector<BDD_ID> &roots);
+        void setAutoReorder(bool enable, size_t firstThreshold = REORDER_MIN_NODES);
+        const ReorderStats &getReorderStats() const;
+        size_t getLevel(BDD_ID x);
+
+        /**
+         * @brief Current variable order as labels, top level first
+         *
+         * exportVariableOrder() writes one label per line after a comment
+         * line starting with '#'; the file can be handed to the benchmark
+         * driver to create the variables of the next run in this order.
+         */
+        std::vector<std::string> getVariableOrder() const;
+        void exportVariableOrder(const std::string &filepath) const;
+
+        /**
+         * @brief Resource limits
+         *
+         * Once the unique table holds maxNodes nodes (0 disables the limit)
+         * or the abort flag is set by another thread, the next operation
+         * that needs a new node throws std::runtime_error. The manager stays
+         * usable; nodes built by the interrupted operation are garbage.
+         */
+        void setNodeLimit(size_t maxNodes);
+        void setAbortFlag(const std::atomic<bool> *flag);
+
+        /**
+         * @brief Parallel apply
+         *
+         * With more than one thread, ite, the binary operations and the
+         * cofactors fork their high branch as a task that idle worker threads
+         * steal (work stealing in the style of Sylvan). New nodes are
+         * published into the unique subtables with a compare-and-swap and the
+         * computed table is shared without locks. The manager itself is still
+         * driven by one client thread at a time; a thread count of 0 or 1
+         * selects the serial engine.
+         */
+        void setThreadCount(size_t threads);
+        size_t getThreadCount() const;
+
+        /**
+         * @brief Thread-safe mode for several client threads
+         *
+         * In this mode any number of threads may share the manager, its
+         * variables and its BDDs. Operations run on the calling thread with
+         * the lock-free unique and computed tables of the parallel engine and
+         * only exclude createVar, garbage collection, compaction, reordering
+         * and the configuration calls, which restructure the tables. The node
+         * store never moves and the variable tables are allocated for
+         * maxVariables up front, so isConstant, isVariable, topVar,
+         * getTopVarName, the one-argument cofactors, findNodes and findVars
+         * take no lock at all; they must not overlap with a restructuring
+         * call. Automatic reordering is suspended while the mode is on, and
+         * the worker pool of setThreadCount is not used.
+         */
+        void setThreadSafe(bool enable, size_t maxVariables = DEFAULT_MAX_VARIABLES);
+        bool isThreadSafe() const;
+
+        /**
+         * @brief Breadth-first apply
+         *
+         * Evaluates every operation level by level (as in CAL): all pending
+         * sub-calls of a variable level are expanded together top-down, and
+         * their nodes are created together bottom-up. This trades the memory
+         * for the pending requests of one operation for local access to the
+         * node store and the subtables, which pays off once the BDDs no
+         * longer fit into the caches. The results are the same as with the
+         * depth-first engine. It is not used with several threads, in
+         * thread-safe mode, for quantification, for substitution or for the
+         * generalized cofactors.
+         */
+        void setBreadthFirst(bool enable);
+        bool isBreadthFirst() const;
+
+        /**
+         * @brief Unique table growth policy
+         *
+         * A subtable doubles once it holds more than maxLoadFactor nodes per
+         * bucket, or earlier when a lookup had to walk more than
+         * maxChainLength nodes while the subtable is at least half that
+         * full. Its nodes then move to the new buckets rehashStep old
+         * buckets at a time with every following insert, so no single
+         * operation pays for rehashing a large level; a step of 0 moves them
+         * all at once. The parallel engine and the thread-safe mode always
+         * rehash at once, between runs.
+         */
+        void setUniqueTableGrowth(double maxLoadFactor = DEFAULT_MAX_LOAD_FACTOR,
+                                  size_t maxChainLength = DEFAULT_MAX_CHAIN_LENGTH,
+                                  size_t rehashStep = DEFAULT_REHASH_STEP);
+
 
         BDD_ID createVar(const std::string &label) override;
         const BDD_ID &True() override;
@@ -108,6 +429,91 @@ namespace ClassProject {
         void findVars(const BDD_ID &root, std::set<BDD_ID> &vars_of_root) override;
         size_t uniqueTableSize() override;
         void visualizeBDD(std::string filepath, BDD_ID &root) override;
+
+        /**
+         * @brief Garbage collection
+         *
+         * Nodes reachable from a registered root, from an explicit root or
+         * from a variable node are live; everything else is freed by
+         * collectGarbage() and its slot is reused for later nodes. IDs of
+         * live nodes stay valid. collectGarbageAndCompact() additionally
+         * renumbers the live nodes densely (children before parents,
+         * otherwise preserving their relative order) and returns the
+         * old-to-new mapping; registered roots are remapped by the manager,
+         * every other ID held by the caller must be remapped by the caller.
+         */
+        void registerRoot(BDD_ID f) override;
+        void unregisterRoot(BDD_ID f) override;
+        size_t collectGarbage() override;
+        size_t collectGarbage(const std::vector<BDD_ID> &roots) override;
+        IdRemap collectGarbageAndCompact(const std::vector<BDD_ID> &roots) override;
+
+        /**
+         * @brief Quantification over a set of variables
+         *
+         * The variables are given as a cube, the conjunction of their
+         * positive literals (True for none); anything else throws
+         * std::invalid_argument. andExists(f, g, cube) is the relational
+         * product exists(f * g, cube), computed in one pass without building
+         * f * g. A quantified level is the disjunction of its cofactors, so
+         * once the high one is True the low one is skipped. Results are kept
+         * in the computed table under their own operation tags.
+         */
+        BDD_ID exists(BDD_ID f, BDD_ID cube) override;
+        BDD_ID forall(BDD_ID f, BDD_ID cube) override;
+        BDD_ID andExists(BDD_ID f, BDD_ID g, BDD_ID cube) override;
+
+        /**
+         * @brief Substitution of functions for variables
+         *
+         * vectorCompose(f, substitution) replaces every variable of the map
+         * by its function simultaneously, compose(f, x, g) replaces only x by
+         * g and permute(f, permutation) renames variables, which may change
+         * their order. Keys (and for permute also values) that are not
+         * variables throw std::invalid_argument. Every distinct substitution
+         * is interned under a number that keys its computed-table entries, so
+         * repeating a renaming hits the entries of the earlier calls; a single
+         * variable is replaced as ite(g, f|x=1, f|x=0) instead. The
+         * manager keeps the substitutions, and with them their functions,
+         * for its whole lifetime; they are meant for a few fixed renamings
+         * such as next-state to current-state variables.
+         */
+        BDD_ID compose(BDD_ID f, BDD_ID x, BDD_ID g) override;
+        BDD_ID vectorCompose(BDD_ID f, const std::map<BDD_ID, BDD_ID> &substitution) override;
+        BDD_ID permute(BDD_ID f, const std::map<BDD_ID, BDD_ID> &permutation) override;
+
+        /**
+         * @brief Generalized cofactors (Coudert and Madre)
+         *
+         * Both results agree with f wherever the care set c is True and are
+         * meant to be smaller than f elsewhere. constrain(f, c) maps every
+         * assignment outside c to the closest one inside c, so it equals the
+         * cofactor for a literal or cube; it may depend on variables that f
+         * does not. restrict(f, c) first drops the variables of c above f by
+         * quantifying them, so its support stays within that of f. Both
+         * return False for an empty care set and are memoized in the
+         * computed table. minimize(f, c) is the safe variant in the spirit
+         * of LI compaction: restrict(f, c), or f itself if that is not
+         * smaller.
+         */
+        BDD_ID constrain(BDD_ID f, BDD_ID c) override;
+        BDD_ID restrict(BDD_ID f, BDD_ID c) override;
+        BDD_ID minimize(BDD_ID f, BDD_ID c) override;
+
+        /**
+         * @brief Checks that never build a node
+         *
+         * leq(f, g) tells whether f implies g and isDisjoint(f, g) whether
+         * f * g is False. Both walk f and g together and stop at the first
+         * pair of cofactors that overlaps. iteConstant(i, t, e) returns the
+         * constant that ite(i, t, e) equals, or NON_CONSTANT, from at most
+         * two such walks. Their answers are memoized in a table of their
+         * own, the check table, so they neither add nodes to the unique
+         * table nor evict entries of the computed table.
+         */
+        bool leq(BDD_ID f, BDD_ID g) override;
+        bool isDisjoint(BDD_ID f, BDD_ID g) override;
+        BDD_ID iteConstant(BDD_ID i, BDD_ID t, BDD_ID e) override;
     };
 
 }
@@ -7,11 +7,27 @@
 
 #include <string>
 #include <set>
+#include <map>
+#include <vector>
 
 namespace ClassProject {
 
     typedef size_t BDD_ID;
 
+    /**
+     * @brief Old-to-new ID mapping returned by a compacting garbage collection
+     *
+     * IDs of nodes that did not survive the collection map to garbage.
+     */
+    struct IdRemap {
+        std::vector<BDD_ID> newIndex;   // indexed by old node index (ID >> 1)
+
+        BDD_ID operator()(BDD_ID f) const { return (newIndex[f >> 1] << 1) | (f & 1); }
+    };
+
+    /// Returned by iteConstant() when the result is not a constant
+    constexpr BDD_ID NON_CONSTANT = ~static_cast<BDD_ID>(0);
+
     class ManagerInterface {
     public:
         virtual BDD_ID createVar(const std::string &label) = 0;
@@ -59,6 +75,40 @@ namespace ClassProject {
         virtual size_t uniqueTableSize() = 0;
 
         virtual void visualizeBDD(std::string filepath, BDD_ID &root) = 0;
+
+        virtual void registerRoot(BDD_ID f) = 0;
+
+        virtual void unregisterRoot(BDD_ID f) = 0;
+
+        virtual size_t collectGarbage() = 0;
+
+        virtual size_t collectGarbage(const std::vector<BDD_ID> &roots) = 0;
+
+        virtual IdRemap collectGarbageAndCompact(const std::vector<BDD_ID> &roots) = 0;
+
+        virtual BDD_ID exists(BDD_ID f, BDD_ID cube) = 0;
+
+        virtual BDD_ID forall(BDD_ID f, BDD_ID cube) = 0;
+
+        virtual BDD_ID andExists(BDD_ID f, BDD_ID g, BDD_ID cube) = 0;
+
+        virtual BDD_ID compose(BDD_ID f, BDD_ID x, BDD_ID g) = 0;
+
+        virtual BDD_ID vectorCompose(BDD_ID f, const std::map<BDD_ID, BDD_ID> &substitution) = 0;
+
+        virtual BDD_ID permute(BDD_ID f, const std::map<BDD_ID, BDD_ID> &permutation) = 0;
+
+        virtual BDD_ID constrain(BDD_ID f, BDD_ID c) = 0;
+
+        virtual BDD_ID restrict(BDD_ID f, BDD_ID c) = 0;
+
+        virtual BDD_ID minimize(BDD_ID f, BDD_ID c) = 0;
+
+        virtual bool leq(BDD_ID f, BDD_ID g) = 0;
+
+        virtual bool isDisjoint(BDD_ID f, BDD_ID g) = 0;
+
+        virtual BDD_ID iteConstant(BDD_ID i, BDD_ID t, BDD_ID e) = 0;
     };
 }
 
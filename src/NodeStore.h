@@ -0,0 +1,197 @@
+// Paged node storage for the BDD manager
+//
+
+#ifndef VDSPROJECT_NODESTORE_H
+#define VDSPROJECT_NODESTORE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define VDS_NODE_STORE_MMAP 1
+#endif
+
+// Ask the kernel for transparent huge pages behind the node store, set by CMake
+#ifndef VDS_HUGE_PAGES
+#define VDS_HUGE_PAGES 1
+#endif
+
+namespace ClassProject {
+
+    /**
+     * @brief Array of nodes that never moves once a slot exists
+     *
+     * Slots live in pages of PAGE_SIZE nodes; a directory maps the page
+     * number to its page, so looking up an index costs two loads. Growing
+     * adds a page instead of copying the nodes. A full directory is replaced
+     * by one twice as large, and the old one is kept until the store dies,
+     * so a reader that still holds it sees the same pages.
+     *
+     * Pages are cut from arena chunks that grow with the store. Where
+     * available the chunks are anonymous mappings aligned to huge pages;
+     * the kernel only backs the parts that were written, and a slot is
+     * written when it is handed out, so the resident size follows the number
+     * of slots and not the reserved chunks.
+     *
+     * allocate() may be called from several threads at once, and so may
+     * reads of slots that were handed out before. New slots hold the fill
+     * node given at construction. swap() and clear() are for exclusive use.
+     */
+    template<typename Node>
+    class NodeStore {
+        static_assert(std::is_trivially_destructible<Node>::value, "pages are freed without destructor calls");
+
+    public:
+        static constexpr size_t PAGE_BITS = 16;
+        static constexpr size_t PAGE_SIZE = static_cast<size_t>(1) << PAGE_BITS;
+
+        explicit NodeStore(const Node &fill) : fill(fill) {}
+        ~NodeStore() { release(); }
+
+        NodeStore(const NodeStore &) = delete;
+        NodeStore &operator=(const NodeStore &) = delete;
+
+        Node &operator[](size_t i) {
+            return directory.load(std::memory_order_acquire)[i >> PAGE_BITS][i & (PAGE_SIZE - 1)];
+        }
+        const Node &operator[](size_t i) const {
+            return directory.load(std::memory_order_acquire)[i >> PAGE_BITS][i & (PAGE_SIZE - 1)];
+        }
+
+        size_t size() const { return count.load(std::memory_order_relaxed); }
+
+        /// Bytes reserved for pages, resident or not
+        size_t reservedBytes() const { return arena.reserved; }
+
+        /// Hands out the next slot, adding a page when needed
+        size_t allocate() {
+            size_t i = count.fetch_add(1, std::memory_order_relaxed);
+            if ((i >> PAGE_BITS) >= pages.load(std::memory_order_acquire)) addPage(i >> PAGE_BITS);
+            new (&(*this)[i]) Node(fill);
+            return i;
+        }
+
+        void push_back(const Node &node) {
+            size_t i = allocate();
+            (*this)[i] = node;
+        }
+
+        /// Drops all slots and pages
+        void clear() {
+            release();
+            count.store(0, std::memory_order_relaxed);
+        }
+
+        void swap(NodeStore &other) {
+            Node **dir = directory.load(std::memory_order_relaxed);
+            directory.store(other.directory.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other.directory.store(dir, std::memory_order_relaxed);
+            size_t n = count.load(std::memory_order_relaxed);
+            count.store(other.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other.count.store(n, std::memory_order_relaxed);
+            n = pages.load(std::memory_order_relaxed);
+            pages.store(other.pages.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other.pages.store(n, std::memory_order_relaxed);
+            std::swap(directoryCapacity, other.directoryCapacity);
+            directories.swap(other.directories);
+            std::swap(arena, other.arena);
+            std::swap(fill, other.fill);
+        }
+
+    private:
+        static constexpr size_t PAGE_BYTES = PAGE_SIZE * sizeof(Node);
+        static constexpr size_t HUGE_PAGE_BYTES = static_cast<size_t>(2) << 20;
+        static constexpr size_t MAX_CHUNK_BYTES = static_cast<size_t>(256) << 20;
+
+        /// Chunks the pages are cut from
+        struct Arena {
+            std::vector<std::pair<void *, size_t>> chunks;
+            char *cursor = nullptr;
+            size_t left = 0;                            // bytes after cursor in the last chunk
+            size_t reserved = 0;                        // bytes of all chunks
+        };
+
+        Node fill;
+        std::atomic<Node **> directory{nullptr};
+        std::atomic<size_t> count{0};                   // slots handed out
+        std::atomic<size_t> pages{0};                   // pages in the directory
+        size_t directoryCapacity = 0;
+        std::vector<std::unique_ptr<Node *[]>> directories;     // current one last
+        Arena arena;
+        std::mutex growLock;
+
+        void addPage(size_t page) {
+            std::lock_guard<std::mutex> lock(growLock);
+            while (pages.load(std::memory_order_relaxed) <= page) {
+                size_t used = pages.load(std::memory_order_relaxed);
+                if (used == directoryCapacity) {
+                    size_t capacity = directoryCapacity == 0 ? 16 : 2 * directoryCapacity;
+                    std::unique_ptr<Node *[]> bigger(new Node *[capacity]);
+                    for (size_t p = 0; p < used; ++p) bigger[p] = directories.back()[p];
+                    directory.store(bigger.get(), std::memory_order_release);
+                    directories.push_back(std::move(bigger));
+                    directoryCapacity = capacity;
+                }
+                if (arena.left < PAGE_BYTES) addChunk();
+                directories.back()[used] = reinterpret_cast<Node *>(arena.cursor);
+                arena.cursor += PAGE_BYTES;
+                arena.left -= PAGE_BYTES;
+                pages.store(used + 1, std::memory_order_release);
+            }
+        }
+
+        /// Reserves a chunk as large as everything before it, within bounds
+        void addChunk() {
+            size_t bytes = std::min(MAX_CHUNK_BYTES, std::max(arena.reserved, HUGE_PAGE_BYTES));
+            bytes = std::max(PAGE_BYTES, bytes / PAGE_BYTES * PAGE_BYTES);
+#ifdef VDS_NODE_STORE_MMAP
+            // over-map by one huge page and trim, so the chunk starts aligned
+            size_t mapped = bytes + HUGE_PAGE_BYTES;
+            void *region = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (region == MAP_FAILED) throw std::bad_alloc();
+            uintptr_t begin = reinterpret_cast<uintptr_t>(region);
+            uintptr_t aligned = (begin + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+            if (aligned != begin) munmap(region, aligned - begin);
+            size_t tail = begin + mapped - (aligned + bytes);
+            if (tail != 0) munmap(reinterpret_cast<void *>(aligned + bytes), tail);
+            void *chunk = reinterpret_cast<void *>(aligned);
+#if VDS_HUGE_PAGES && defined(MADV_HUGEPAGE)
+            madvise(chunk, bytes, MADV_HUGEPAGE);
+#endif
+#else
+            void *chunk = ::operator new(bytes);
+#endif
+            arena.chunks.emplace_back(chunk, bytes);
+            arena.cursor = static_cast<char *>(chunk);
+            arena.left = bytes;
+            arena.reserved += bytes;
+        }
+
+        void release() {
+            for (auto &chunk : arena.chunks) {
+#ifdef VDS_NODE_STORE_MMAP
+                munmap(chunk.first, chunk.second);
+#else
+                ::operator delete(chunk.first);
+#endif
+            }
+            arena = Arena();
+            directories.clear();
+            directory.store(nullptr, std::memory_order_relaxed);
+            pages.store(0, std::memory_order_relaxed);
+            directoryCapacity = 0;
+        }
+    };
+
+}
+
+#endif
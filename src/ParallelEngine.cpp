@@ -0,0 +1,409 @@
+#include "ParallelEngine.h"
+#include <algorithm>
+#include <stdexcept>
+
+
+
+namespace ClassProject {
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Worker threads: the calling thread is worker 0, the helpers sleep between
+// runs and steal while one is active
+///////////////////////////////////////////////////////////////////////////////
+Manager::ParallelEngine::ParallelEngine(Manager &manager, size_t threads) : manager(manager) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(new Worker);
+        workers.back()->random.seed(static_cast<unsigned>(i + 1));
+    }
+    for (size_t i = 1; i < threads; ++i) {
+        this->threads.emplace_back(&ParallelEngine::helper, this, i);
+    }
+}
+
+Manager::ParallelEngine::~ParallelEngine() {
+    {
+        std::lock_guard<std::mutex> lock(phaseLock);
+        stopping = true;
+    }
+    phaseStart.notify_all();
+    for (auto &thread : threads) thread.join();
+}
+
+void Manager::ParallelEngine::helper(size_t id) {
+    Worker &w = *workers[id];
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(phaseLock);
+            phaseStart.wait(lock, [&]() { return stopping || phase != seen; });
+            if (stopping) return;
+            seen = phase;
+        }
+        // announce before looking at active, so run() cannot miss this helper
+        busy.fetch_add(1);
+        while (active.load()) {
+            if (!steal(w)) std::this_thread::yield();
+        }
+        busy.fetch_sub(1);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// One top-level operation on the worker pool
+// A run that had to stop for a larger subtable is repeated once the manager
+// has grown it.
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::ParallelEngine::run(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h) {
+    // workers only know the new buckets of a growing subtable
+    manager.finishRehashes();
+    for (;;) {
+        const size_t first = manager.uniqueTable.size();
+        reusable = manager.freeNodes.size();
+        reused.store(0);
+        cancelled.store(false);
+
+        {
+            std::lock_guard<std::mutex> lock(phaseLock);
+            active.store(true);
+            ++phase;
+        }
+        phaseStart.notify_all();
+
+        BDD_ID result = 0;
+        try {
+            result = apply(*workers[0], op, f, g, h);
+        } catch (...) {
+            fail(std::current_exception());
+        }
+
+        active.store(false);
+        while (busy.load() != 0) std::this_thread::yield();
+        finishRun(first);
+
+        std::exception_ptr error;
+        error.swap(failure);
+        if (!error) return result;
+        try {
+            std::rethrow_exception(error);
+        } catch (const Restart &) {
+            // run again, anything else goes to the caller
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// One operation of a client thread in thread-safe mode
+// The client evaluates it on its own, without forking. Returns false if a
+// subtable has to grow first, which needs the manager's exclusive lock.
+///////////////////////////////////////////////////////////////////////////////
+bool Manager::ParallelEngine::runShared(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h, BDD_ID &result) {
+    static thread_local Worker client;
+    client.pooled = false;
+    bool done = false;
+    try {
+        result = apply(client, op, f, g, h);
+        done = true;
+    } catch (const Restart &) {
+    } catch (...) {
+        mergeStatistics(client);
+        throw;
+    }
+    mergeStatistics(client);
+    return done;
+}
+
+void Manager::ParallelEngine::mergeStatistics(Worker &w) {
+    std::lock_guard<std::mutex> lock(manager.statsLock);
+    manager.computedTable.lookups += w.lookups;
+    manager.computedTable.hits += w.hits;
+    w.lookups = w.hits = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: bring the manager up to date with the nodes of a finished run
+///////////////////////////////////////////////////////////////////////////////
+void Manager::ParallelEngine::finishRun(size_t firstSlot) {
+    // claimed free slots leave the end of the list, unless they were lost to a race
+    std::vector<size_t> &freeNodes = manager.freeNodes;
+    size_t kept = freeNodes.size() - std::min(reused.load(), reusable);
+    for (size_t k = kept, end = freeNodes.size(); k < end; ++k) {
+        const BDDNode &n = manager.uniqueTable[freeNodes[k]];
+        if (n.level == FREE_LEVEL) freeNodes[kept++] = freeNodes[k];
+        else ++manager.subtables[n.level].keys;
+    }
+    freeNodes.resize(kept);
+    reusable = 0;
+
+    const size_t end = manager.uniqueTable.size();
+    for (size_t i = firstSlot; i < end; ++i) {
+        const BDDNode &n = manager.uniqueTable[i];
+        // slots lost to a race were never published
+        if (n.level == FREE_LEVEL) freeNodes.push_back(i);
+        else ++manager.subtables[n.level].keys;
+    }
+    growOverloaded();
+    for (VarIndex level = 0; level < manager.subtables.size(); ++level) {
+        Subtable &table = manager.subtables[level];
+        size_t bucketCount = manager.bucketsFor(table.keys, table.bucketCount);
+        if (bucketCount != table.bucketCount) manager.resizeSubtable(level, bucketCount);
+    }
+
+    for (auto &w : workers) {
+        manager.computedTable.lookups += w->lookups;
+        manager.computedTable.hits += w->hits;
+        w->lookups = w->hits = 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: grow the subtables whose chains got too long; the manager's
+// tables must not be in use
+///////////////////////////////////////////////////////////////////////////////
+void Manager::ParallelEngine::growOverloaded() {
+    // several workers may have reported the same level
+    std::sort(overloaded.begin(), overloaded.end());
+    overloaded.erase(std::unique(overloaded.begin(), overloaded.end()), overloaded.end());
+    for (VarIndex level : overloaded) {
+        Subtable &table = manager.subtables[level];
+        manager.resizeSubtable(level, manager.bucketsFor(2 * table.keys, table.bucketCount << 1));
+    }
+    overloaded.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: the first error of a run cancels all workers
+///////////////////////////////////////////////////////////////////////////////
+void Manager::ParallelEngine::fail(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(failureLock);
+    if (!failure) failure = error;
+    cancelled.store(true);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Fork/join apply
+// Same terminal cases, normalization and cache keys as the serial engine.
+// A failing sub-call is rethrown only after the forked task was joined, as
+// the task lives in this frame; a task nobody stole is then dropped. Client
+// threads in thread-safe mode do not fork.
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::ParallelEngine::apply(Worker &w, CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h) {
+    if (w.pooled && cancelled.load(std::memory_order_relaxed)) throw Cancelled();
+    BDD_ID flags = 0, result = 0;
+    if (manager.reduceApply(op, f, g, h, flags, result)) return result;
+    if (opTag(op) == OP_RESTRICT && manager.node(g).level < manager.node(f).level) {
+        // as in the serial engine, a care variable above f is quantified first
+        BDD_ID highG, lowG;
+        manager.topCofactors(g, manager.node(g).level, highG, lowG);
+        const BDD_ID care = complement(apply(w, OP_AND, complement(highG), complement(lowG), 0));
+        return apply(w, op, f, care, h) ^ flags;
+    }
+    ++w.lookups;
+    if (manager.computedTable.lookupShared(op, f, g, h, result)) {
+        ++w.hits;
+        return result ^ flags;
+    }
+
+    VarIndex level;
+    BDD_ID highF, highG, highH, lowF, lowG, lowH;
+    const Combine how = manager.splitApply(op, f, g, h, level, highF, highG, highH, lowF, lowG, lowH);
+
+    if (!w.pooled) {
+        BDD_ID high = apply(w, op, highF, highG, highH);
+        // the low cofactor does not matter once the disjunction is True
+        BDD_ID low = how == COMBINE_OR && high == manager.trueId ? high : apply(w, op, lowF, lowG, lowH);
+        BDD_ID res = combine(w, op, how, g, h, high, low, level);
+        manager.computedTable.insertShared(op, f, g, h, res);
+        return res ^ flags;
+    }
+
+    Task high(op, highF, highG, highH);
+    {
+        std::lock_guard<std::mutex> lock(w.lock);
+        w.tasks.push_back(&high);
+    }
+    BDD_ID low = 0;
+    std::exception_ptr error;
+    try {
+        low = apply(w, op, lowF, lowG, lowH);
+    } catch (...) {
+        error = std::current_exception();
+        fail(error);
+    }
+    // a True low cofactor of a quantified level makes the high one unnecessary
+    const bool decided = error == nullptr && how == COMBINE_OR && low == manager.trueId;
+    join(w, high, error != nullptr || decided);
+    if (error) std::rethrow_exception(error);
+
+    BDD_ID res;
+    if (decided) {
+        res = manager.trueId;
+    } else {
+        if (high.error) std::rethrow_exception(high.error);
+        res = combine(w, op, how, g, h, high.result, low, level);
+    }
+    manager.computedTable.insertShared(op, f, g, h, res);
+    return res ^ flags;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: result of a call from the results of its sub-calls, as in the
+// serial engine
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::ParallelEngine::combine(Worker &w, CacheOp op, Combine how, BDD_ID g, BDD_ID h,
+                                        BDD_ID high, BDD_ID low, VarIndex level) {
+    if (how == COMBINE_NODE) return findOrCreateNode(high, low, level);
+    if (how == COMBINE_OR) {
+        if (high == manager.trueId || low == manager.trueId) return manager.trueId;
+        return complement(apply(w, OP_AND, complement(high), complement(low), 0));
+    }
+    const BDD_ID replaced = manager.replacement(op, g, h, level);
+    if (manager.keepsNode(replaced, high, low, level)) return findOrCreateNode(high, low, level);
+    return apply(w, OP_ITE, replaced, high, low);
+}
+
+void Manager::ParallelEngine::execute(Worker &w, Task &task) {
+    try {
+        task.result = apply(w, task.op, task.f, task.g, task.h);
+    } catch (...) {
+        task.error = std::current_exception();
+        fail(task.error);
+    }
+    task.done.store(true, std::memory_order_release);
+}
+
+void Manager::ParallelEngine::join(Worker &w, Task &task, bool discard) {
+    bool mine = false;
+    {
+        std::lock_guard<std::mutex> lock(w.lock);
+        // tasks forked later were joined already, so an unstolen task is last
+        if (!w.tasks.empty() && w.tasks.back() == &task) {
+            w.tasks.pop_back();
+            mine = true;
+        }
+    }
+    if (mine) {
+        if (!discard) execute(w, task);
+        return;
+    }
+    while (!task.done.load(std::memory_order_acquire)) {
+        if (!steal(w)) std::this_thread::yield();
+    }
+}
+
+bool Manager::ParallelEngine::steal(Worker &w) {
+    const size_t count = workers.size();
+    size_t victim = w.random() % count;
+    for (size_t k = 0; k < count; ++k, victim = (victim + 1) % count) {
+        Worker &v = *workers[victim];
+        if (&v == &w) continue;
+        Task *task = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(v.lock);
+            if (!v.tasks.empty()) {
+                task = v.tasks.front();
+                v.tasks.pop_front();
+            }
+        }
+        if (task != nullptr) {
+            execute(w, *task);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper: lock-free unique table lookup
+// A node is filled in before it is published with a compare-and-swap on its
+// chain head. When the head moved in the meantime only the nodes pushed in
+// front of the old head need to be checked before retrying; a worker that
+// finds its node already there gives up its slot.
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::ParallelEngine::findOrCreateNode(BDD_ID high, BDD_ID low, VarIndex level) {
+    if (high == low) return high;
+
+    if (isComplemented(low)) {
+        return complement(findOrCreateNode(complement(high), complement(low), level));
+    }
+
+    NodeStore<BDDNode> &nodes = manager.uniqueTable;
+    std::atomic<NodeRef> &head = manager.subtables[level].head(high, low);
+    NodeRef seen = head.load(std::memory_order_acquire);
+    size_t chain = 0;
+    for (size_t idx = seen; idx != 0; idx = nodes[idx].next, ++chain) {
+        if (nodes[idx].high == high && nodes[idx].low == low) return idx << 1;
+    }
+
+    if (manager.abortFlag != nullptr && manager.abortFlag->load(std::memory_order_relaxed)) {
+        throw std::runtime_error("BDD operation aborted");
+    }
+    if (chain >= MAX_CHAIN) {
+        std::lock_guard<std::mutex> lock(overloadLock);
+        overloaded.push_back(level);
+        throw Restart();
+    }
+    // freeNodes does not change while workers run
+    std::vector<size_t> &freeNodes = manager.freeNodes;
+    if (manager.nodeLimit != 0 &&
+        nodes.size() - (freeNodes.size() - std::min(reused.load(std::memory_order_relaxed), reusable)) >=
+            manager.nodeLimit) {
+        throw std::runtime_error("Node limit exceeded");
+    }
+    size_t idx = 0;                                     // the terminal's slot is never free
+    if (reused.load(std::memory_order_relaxed) < reusable) {
+        // reuse a slot released by the garbage collector
+        const size_t claim = reused.fetch_add(1, std::memory_order_relaxed);
+        if (claim < reusable) idx = freeNodes[freeNodes.size() - 1 - claim];
+    }
+    if (idx == 0) {
+        idx = nodes.allocate();
+        if (idx >= MAX_NODES) {
+            throw std::runtime_error("Unique table exceeds the node reference width");
+        }
+    }
+
+    BDDNode &n = nodes[idx];
+    n = BDDNode(high, low, level);
+    for (;;) {
+        n.next = seen;
+        if (head.compare_exchange_weak(seen, static_cast<NodeRef>(idx),
+                                       std::memory_order_release, std::memory_order_acquire)) {
+            return idx << 1;
+        }
+        for (size_t other = seen; other != n.next; other = nodes[other].next) {
+            if (nodes[other].high == high && nodes[other].low == low) {
+                n.level = FREE_LEVEL;
+                return other << 1;
+            }
+        }
+    }
+}
+
+} // namespace ClassProject
+
+
+namespace ClassProject {
+
+///////////////////////////////////////////////////////////////////////////////
+// Thread-safe mode: a client operation runs under the shared table lock and
+// takes the exclusive lock only to grow a subtable, then starts over
+///////////////////////////////////////////////////////////////////////////////
+BDD_ID Manager::concurrentApply(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h) {
+    for (;;) {
+        {
+            std::shared_lock<std::shared_mutex> lock(tableLock);
+            BDD_ID result;
+            if (parallel->runShared(op, f, g, h, result)) return result;
+        }
+        std::unique_lock<std::shared_mutex> lock(tableLock);
+        parallel->growOverloaded();
+    }
+}
+
+} // namespace ClassProject
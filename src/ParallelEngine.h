@@ -0,0 +1,112 @@
+// Work-stealing parallel apply for the BDD manager
+//
+
+#ifndef VDSPROJECT_PARALLELENGINE_H
+#define VDSPROJECT_PARALLELENGINE_H
+
+#include "Manager.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace ClassProject {
+
+    /**
+     * @brief Fork/join evaluator running one apply operation on several threads
+     *
+     * Every step of an apply call forks its high sub-call as a task on the
+     * deque of the running worker and computes the low sub-call itself. At the
+     * join the worker takes the task back unless it was stolen, in which case
+     * it steals other work until the thief is done. Idle workers take the
+     * oldest task of a random victim, which is the largest piece of work.
+     *
+     * New nodes get a slot of the node store, which never moves, and are
+     * published with a compare-and-swap on the chain head of their subtable.
+     * Subtables are not resized during a run. Freed slots are claimed from
+     * the end of the manager's free list with an atomic cursor, and the list
+     * is only shortened after the run; client threads in thread-safe mode,
+     * whose free list is only recounted under the exclusive lock, always take
+     * new slots.
+     * When a chain grows too long, the run is abandoned, the manager grows the
+     * subtable and the run starts over; what was computed before is found
+     * again in the unique and computed tables.
+     *
+     * The calling thread is worker 0. The recursion of the workers is bounded
+     * by the number of variables plus the nesting of stolen tasks. In
+     * thread-safe mode every client thread evaluates its own operations with
+     * runShared() on the same tables, without forking.
+     */
+    class Manager::ParallelEngine {
+    public:
+        ParallelEngine(Manager &manager, size_t threads);
+        ~ParallelEngine();
+
+        BDD_ID run(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h);
+        bool runShared(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h, BDD_ID &result);
+        void growOverloaded();
+        size_t threadCount() const { return workers.size(); }
+
+    private:
+        static constexpr size_t MAX_CHAIN = 16;            // chain length that asks for a larger subtable
+
+        struct Task {
+            CacheOp op;
+            BDD_ID f, g, h;
+            BDD_ID result = 0;
+            std::exception_ptr error;
+            std::atomic<bool> done{false};
+
+            Task(CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h) : op(op), f(f), g(g), h(h) {}
+        };
+
+        struct Worker {
+            std::mutex lock;
+            std::deque<Task *> tasks;       // forked and neither joined nor stolen, newest last
+            std::minstd_rand random;
+            size_t lookups = 0, hits = 0;   // computed table statistics, merged after a run
+            bool pooled = true;             // forks its high branches
+        };
+
+        /// Thrown by a worker that needs the manager to grow a table
+        struct Restart {};
+        /// Thrown by every worker once another one failed
+        struct Cancelled {};
+
+        Manager &manager;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+
+        std::mutex phaseLock;
+        std::condition_variable phaseStart;
+        uint64_t phase = 0;
+        bool stopping = false;
+        std::atomic<bool> active{false};
+        std::atomic<size_t> busy{0};                // helpers inside the current run
+
+        std::atomic<bool> cancelled{false};
+        std::mutex failureLock;
+        std::exception_ptr failure;                 // first error of the current run
+        std::mutex overloadLock;
+        std::vector<VarIndex> overloaded;           // levels whose chains grew too long
+        size_t reusable = 0;                        // free slots the current run may claim
+        std::atomic<size_t> reused{0};              // claims so far, may overshoot reusable
+
+        BDD_ID apply(Worker &w, CacheOp op, BDD_ID f, BDD_ID g, BDD_ID h);
+        void execute(Worker &w, Task &task);
+        void join(Worker &w, Task &task, bool discard);
+        void fail(std::exception_ptr error);
+        bool steal(Worker &w);
+        BDD_ID findOrCreateNode(BDD_ID high, BDD_ID low, VarIndex level);
+        BDD_ID combine(Worker &w, CacheOp op, Combine how, BDD_ID g, BDD_ID h, BDD_ID high, BDD_ID low,
+                       VarIndex level);
+        void helper(size_t id);
+        void finishRun(size_t firstSlot);
+        void mergeStatistics(Worker &w);
+    };
+
+}
+
+#endif
@@ -141,5 +141,9 @@ void process_mem_usage(double& vm_usage, double& resident_set)
 
 }
 
-
-
+long peak_resident_set()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;    // kB on Linux
+}
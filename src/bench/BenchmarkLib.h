@@ -61,4 +61,7 @@ long long memUsing();
 
 void process_mem_usage(double& vm_usage, double& resident_set);
 
+// returns the peak resident set size of the process in kB
+long peak_resident_set();
+
 #endif /* BENCHMARKLIB_H_ */
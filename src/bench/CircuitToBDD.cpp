@@ -6,6 +6,7 @@
 #include "CircuitToBDD.hpp"
 
 #include <utility>
+#include <algorithm>
 
 
 CircuitToBDD::CircuitToBDD(shared_ptr<ClassProject::ManagerInterface> BDD_manager_p) {
@@ -15,30 +16,39 @@ CircuitToBDD::CircuitToBDD(shared_ptr<ClassProject::ManagerInterface> BDD_manage
 CircuitToBDD::~CircuitToBDD() = default;
 
 void CircuitToBDD::GenerateBDD(const list_of_circuit_t &circuit, const std::string& benchmark_file) {
-    ClassProject::BDD_ID BDD_node;
+    BuildBDD(circuit);
+    WriteResults(circuit, benchmark_file);
+}
 
-    std::filesystem::path pathToBenchFile(benchmark_file);
-    if (!pathToBenchFile.has_filename())
-        throw std::runtime_error("circuit_to_BDD_manager::GenerateBDD: benchmark_file not specified");
-    if (!std::filesystem::exists(benchmark_file))
-        throw std::runtime_error("circuit_to_BDD_manager::GenerateBDD: benchmark_file doesn't exist");
-    result_dir = "results_" + pathToBenchFile.stem().string();
 
-    if (!(std::filesystem::exists(result_dir)) && !std::filesystem::create_directory(result_dir)) {
-        throw std::runtime_error("Unable to create directory 'result' for the output!");
+void CircuitToBDD::BuildBDD(const list_of_circuit_t &circuit) {
+    for (const auto &circuit_node : circuit) {
+        for (const auto input : circuit_node.input_id_list) {
+            ++pending_fanout[input];
+        }
     }
 
-    std::ofstream bdd_out_file(result_dir + "/BNode_BDD.csv");
-
-    if (!bdd_out_file.is_open()) {
-        throw std::runtime_error("Unable to open Log File!");
+    /* All variables are created up front, in the order chosen by the heuristic */
+    std::unordered_map<unique_ID_t, ClassProject::BDD_ID> input_vars;
+    std::unordered_map<unique_ID_t, const circuit_node_t *> id_to_node;
+    for (const auto &circuit_node : circuit) {
+        id_to_node[circuit_node.id] = &circuit_node;
+    }
+    std::vector<unique_ID_t> input_ids = ComputeInputOrder(circuit);
+    if (!input_order_file.empty()) {
+        input_ids = ApplyOrderFile(circuit, input_ids);
+    }
+    for (const auto input : input_ids) {
+        input_vars[input] = InputGate(id_to_node.at(input)->label);
     }
-
-    bdd_out_file << "BDD_ID,Bench Label" << std::endl;
 
     for (const auto &circuit_node : circuit) {
+        /* OUTPUT or FLIP FLOP gates do not generate a BDD */
+        if ((circuit_node.gate_type == OUTPUT_GATE_T) | (circuit_node.gate_type == FLIP_FLOP_GATE_T)) continue;
+
+        ClassProject::BDD_ID BDD_node;
         if (circuit_node.gate_type == INPUT_GATE_T) {
-            BDD_node = InputGate(circuit_node.label);
+            BDD_node = input_vars.at(circuit_node.id);
         } else if (circuit_node.gate_type == NOT_GATE_T) {
             BDD_node = NotGate(circuit_node.input_id_list);
         } else if (circuit_node.gate_type == AND_GATE_T) {
@@ -53,13 +63,49 @@ void CircuitToBDD::GenerateBDD(const list_of_circuit_t &circuit, const std::stri
             BDD_node = XorGate(circuit_node.input_id_list);
         } else if (circuit_node.gate_type == BUFFER_GATE_T) {
             BDD_node = findBddId(*circuit_node.input_id_list.begin());
+        } else {
+            throw std::runtime_error("Unknown gate type " + circuit_node.gate_type + " of " + circuit_node.label);
         }
 
-        /* OUTPUT or FLIP FLOP gates do not generate a BDD */
-        if (!((circuit_node.gate_type == OUTPUT_GATE_T) | (circuit_node.gate_type == FLIP_FLOP_GATE_T))) {
-            node_to_bdd_id.insert(std::pair<unique_ID_t, ClassProject::BDD_ID>(circuit_node.id, BDD_node));
-            label_to_bdd_id.insert(std::pair<label_t, ClassProject::BDD_ID>(circuit_node.label, BDD_node));
-            bdd_out_file << BDD_node << "," << circuit_node.label << std::endl;
+        node_to_bdd_id.insert(std::pair<unique_ID_t, ClassProject::BDD_ID>(circuit_node.id, BDD_node));
+        label_to_node_id.insert(std::pair<label_t, unique_ID_t>(circuit_node.label, circuit_node.id));
+        bdd_manager->registerRoot(BDD_node);
+        releaseInputs(circuit_node);
+    }
+}
+
+
+void CircuitToBDD::WriteResults(const list_of_circuit_t &circuit, const std::string &benchmark_file) {
+    std::filesystem::path pathToBenchFile(benchmark_file);
+    if (!pathToBenchFile.has_filename())
+        throw std::runtime_error("circuit_to_BDD_manager::GenerateBDD: benchmark_file not specified");
+    if (!std::filesystem::exists(benchmark_file))
+        throw std::runtime_error("circuit_to_BDD_manager::GenerateBDD: benchmark_file doesn't exist");
+    result_dir = "results_" + pathToBenchFile.stem().string();
+
+    if (!(std::filesystem::exists(result_dir)) && !std::filesystem::create_directory(result_dir)) {
+        throw std::runtime_error("Unable to create directory 'result' for the output!");
+    }
+
+    std::ofstream bdd_out_file(result_dir + "/BNode_BDD.csv");
+
+    if (!bdd_out_file.is_open()) {
+        throw std::runtime_error("Unable to open Log File!");
+    }
+
+    bdd_out_file << "BDD_ID,Bench Label" << std::endl;
+
+    /* Renumber the live nodes densely with children before parents, which
+     * reordering may have broken; only live nodes keep their BDD ID */
+    ClassProject::IdRemap remap = bdd_manager->collectGarbageAndCompact({});
+    for (auto &entry : node_to_bdd_id) {
+        entry.second = remap(entry.second);
+    }
+
+    for (const auto &circuit_node : circuit) {
+        auto bdd_id_it = node_to_bdd_id.find(circuit_node.id);
+        if (bdd_id_it != node_to_bdd_id.end()) {
+            bdd_out_file << bdd_id_it->second << "," << circuit_node.label << std::endl;
         }
     }
 
@@ -67,6 +113,159 @@ void CircuitToBDD::GenerateBDD(const list_of_circuit_t &circuit, const std::stri
 }
 
 
+void CircuitToBDD::SetInputOrder(InputOrder order) {
+    input_order = order;
+}
+
+
+void CircuitToBDD::SetInputOrderFile(const std::string &order_file) {
+    input_order_file = order_file;
+}
+
+
+std::vector<unique_ID_t> CircuitToBDD::ApplyOrderFile(const list_of_circuit_t &circuit,
+                                                      const std::vector<unique_ID_t> &order) const {
+    std::ifstream order_in(input_order_file);
+    if (!order_in.is_open()) {
+        throw std::runtime_error("Unable to open variable order file " + input_order_file);
+    }
+
+    std::unordered_map<label_t, unique_ID_t> input_ids;
+    for (const auto &circuit_node : circuit) {
+        if (circuit_node.gate_type == INPUT_GATE_T) input_ids[circuit_node.label] = circuit_node.id;
+    }
+
+    std::vector<unique_ID_t> file_order;
+    std::set<unique_ID_t> listed;
+    std::string line;
+    while (std::getline(order_in, line)) {
+        boost::algorithm::trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        auto input_it = input_ids.find(line);
+        if (input_it != input_ids.end() && listed.insert(input_it->second).second) {
+            file_order.push_back(input_it->second);
+        }
+    }
+    for (const auto input : order) {
+        if (listed.count(input) == 0) file_order.push_back(input);
+    }
+    return file_order;
+}
+
+
+std::vector<unique_ID_t> CircuitToBDD::ComputeInputOrder(const list_of_circuit_t &circuit) const {
+    std::vector<unique_ID_t> order;
+    std::vector<unique_ID_t> roots;
+    std::unordered_map<unique_ID_t, const circuit_node_t *> id_to_node;
+
+    for (const auto &circuit_node : circuit) {
+        id_to_node[circuit_node.id] = &circuit_node;
+        if (circuit_node.gate_type == INPUT_GATE_T && input_order == InputOrder::Topological) {
+            order.push_back(circuit_node.id);
+        }
+        if (circuit_node.gate_type == OUTPUT_GATE_T || circuit_node.gate_type == FLIP_FLOP_GATE_T) {
+            roots.push_back(circuit_node.id);
+        }
+    }
+    if (input_order == InputOrder::Topological) return order;
+
+    std::unordered_map<unique_ID_t, size_t> placed;   // input -> position in order
+    auto place = [&](unique_ID_t id) {
+        if (placed.emplace(id, order.size()).second) order.push_back(id);
+    };
+
+    if (input_order == InputOrder::DepthFirst) {
+        /* Logic depth of every node, the circuit is topologically sorted */
+        std::unordered_map<unique_ID_t, size_t> depth;
+        for (const auto &circuit_node : circuit) {
+            size_t d = 0;
+            for (const auto input : circuit_node.input_id_list) {
+                d = std::max(d, depth[input] + 1);
+            }
+            depth[circuit_node.id] = d;
+        }
+        auto deeper = [&depth](unique_ID_t a, unique_ID_t b) {
+            return depth.at(a) != depth.at(b) ? depth.at(a) > depth.at(b) : a < b;
+        };
+
+        std::stable_sort(roots.begin(), roots.end(), deeper);
+        std::unordered_map<unique_ID_t, bool> visited;
+        for (const auto root : roots) {
+            std::vector<unique_ID_t> stack{root};
+            while (!stack.empty()) {
+                unique_ID_t id = stack.back();
+                stack.pop_back();
+                if (visited[id]) continue;
+                visited[id] = true;
+
+                const circuit_node_t &circuit_node = *id_to_node.at(id);
+                if (circuit_node.gate_type == INPUT_GATE_T) {
+                    place(id);
+                    continue;
+                }
+                /* Pushed shallowest first so the deepest fanin is visited next */
+                std::vector<unique_ID_t> fanins(circuit_node.input_id_list.begin(), circuit_node.input_id_list.end());
+                std::sort(fanins.begin(), fanins.end(), deeper);
+                for (auto it = fanins.rbegin(); it != fanins.rend(); ++it) {
+                    if (!visited[*it]) stack.push_back(*it);
+                }
+            }
+        }
+    } else {
+        /* Every root carries weight 1, a gate splits its weight evenly over its fanins */
+        std::unordered_map<unique_ID_t, double> weight;
+        for (const auto root : roots) {
+            weight[root] += 1.0;
+        }
+        std::vector<unique_ID_t> inputs;
+        for (auto it = circuit.rbegin(); it != circuit.rend(); ++it) {
+            if (it->gate_type == INPUT_GATE_T) {
+                inputs.push_back(it->id);
+                continue;
+            }
+            if (it->input_id_list.empty()) continue;
+            double share = weight[it->id] / static_cast<double>(it->input_id_list.size());
+            for (const auto input : it->input_id_list) {
+                weight[input] += share;
+            }
+        }
+        std::reverse(inputs.begin(), inputs.end());
+        std::stable_sort(inputs.begin(), inputs.end(), [&weight](unique_ID_t a, unique_ID_t b) {
+            return weight[a] > weight[b];
+        });
+        for (const auto input : inputs) {
+            if (weight[input] > 0.0) place(input);
+        }
+    }
+
+    /* Inputs that no root depends on */
+    for (const auto &circuit_node : circuit) {
+        if (circuit_node.gate_type == INPUT_GATE_T) place(circuit_node.id);
+    }
+    return order;
+}
+
+
+void CircuitToBDD::releaseInputs(const circuit_node_t &circuit_node) {
+    for (const auto input : circuit_node.input_id_list) {
+        if (--pending_fanout[input] != 0) continue;
+
+        auto bdd_id_it = node_to_bdd_id.find(input);
+        if (bdd_id_it == node_to_bdd_id.end()) continue;
+        bdd_manager->unregisterRoot(bdd_id_it->second);
+        node_to_bdd_id.erase(bdd_id_it);
+    }
+
+    if (bdd_manager->uniqueTableSize() < gc_threshold) return;
+
+    ClassProject::IdRemap remap = bdd_manager->collectGarbageAndCompact({});
+    for (auto &entry : node_to_bdd_id) {
+        entry.second = remap(entry.second);
+    }
+    gc_threshold = std::max(GC_MIN_NODES, 2 * bdd_manager->uniqueTableSize());
+}
+
+
 ClassProject::BDD_ID CircuitToBDD::findBddId(unique_ID_t circuit_node) {
 
     auto bdd_id_it = node_to_bdd_id.find(circuit_node);
@@ -216,9 +415,10 @@ void CircuitToBDD::PrintBDD(const std::set<label_t> &output_labels) {
 
     for (const auto &output_label : output_labels) {
 
-        auto output_id_it = label_to_bdd_id.find(output_label);
+        auto output_node_it = label_to_node_id.find(output_label);
 
-        if (output_id_it != label_to_bdd_id.end()) {
+        if (output_node_it != label_to_node_id.end()) {
+            ClassProject::BDD_ID output_id = findBddId(output_node_it->second);
 
             std::string dot_file_name = result_dir + "/dot/" + std::string(output_label) + ".dot";
             std::string txt_file_name = result_dir + "/txt/" + std::string(output_label) + ".txt";
@@ -232,8 +432,8 @@ void CircuitToBDD::PrintBDD(const std::set<label_t> &output_labels) {
 
             output_nodes.clear();
             output_vars.clear();
-            bdd_manager->findNodes(output_id_it->second, output_nodes);
-            bdd_manager->findVars(output_id_it->second, output_vars);
+            bdd_manager->findNodes(output_id, output_nodes);
+            bdd_manager->findVars(output_id, output_vars);
 
             dumpBddText(bdd_out_txt_file);
             dumpBddDot(bdd_out_dot_file);
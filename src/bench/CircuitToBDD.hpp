@@ -10,6 +10,17 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <vector>
+
+
+/**
+ * \brief Heuristics for the order in which circuit inputs become BDD variables
+ */
+enum class InputOrder {
+    Topological,    ///< order in which the topological sort emits the inputs
+    DepthFirst,     ///< depth-first fanin traversal from the outputs, deepest fanin first
+    FanoutWeight    ///< largest share of output weight first, weights split evenly over fanins
+};
 
 
 /**
@@ -39,6 +50,46 @@ public:
      */
     void GenerateBDD(const std::list<circuit_node_t> &circuit, const std::string& benchmark_file);
 
+    /**
+     * \brief Builds the BDDs of the circuit nodes without writing any file
+     * \param Topologically sorted list containing the circuit nodes
+     * \return none
+     *
+     *  First half of GenerateBDD. It only touches this object and its
+     *   manager, so converters with separate managers can build in parallel.
+     */
+    void BuildBDD(const std::list<circuit_node_t> &circuit);
+
+    /**
+     * \brief Writes the BDD ID of every live circuit node to BNode_BDD.csv
+     * \param Topologically sorted list containing the circuit nodes
+     * \param benchmark_file names the result directory
+     * \return none
+     *
+     *  Second half of GenerateBDD, called after BuildBDD.
+     */
+    void WriteResults(const std::list<circuit_node_t> &circuit, const std::string &benchmark_file);
+
+    /**
+     * \brief Selects how the variable order is derived from the circuit
+     * \param order is the heuristic used by the next GenerateBDD call
+     * \return none
+     *
+     *  All variables are created in this order before any gate is processed.
+     */
+    void SetInputOrder(InputOrder order);
+
+    /**
+     * \brief Reads the variable order from a file instead of computing it
+     * \param order_file lists input labels one per line, '#' starts a comment line
+     * \return none
+     *
+     *  Listed inputs are created first and in file order; inputs missing
+     *  from the file follow in the order of the selected heuristic, labels
+     *  that are not inputs of the circuit are ignored.
+     */
+    void SetInputOrderFile(const std::string &order_file);
+
 
     /**
      * \brief Print the generated BDD in text and dot format
@@ -50,7 +101,14 @@ public:
 private:
 
     std::unordered_map<unique_ID_t, ClassProject::BDD_ID> node_to_bdd_id; ///< Mapping from circuit node's unique ID to its BDD ID
-    std::unordered_map<label_t, ClassProject::BDD_ID> label_to_bdd_id; ///< Mapping from node's label to its BDD ID
+    std::unordered_map<label_t, unique_ID_t> label_to_node_id; ///< Mapping from node's label to its circuit unique ID
+    std::unordered_map<unique_ID_t, size_t> pending_fanout; ///< Number of not yet processed readers of a circuit node
+
+    static constexpr size_t GC_MIN_NODES = 1 << 17; ///< Unique table size that first triggers a garbage collection
+    size_t gc_threshold = GC_MIN_NODES;
+
+    InputOrder input_order = InputOrder::Topological;
+    std::string input_order_file; ///< Variable order file, empty if none
 
     shared_ptr<ClassProject::ManagerInterface> bdd_manager{};
     std::string result_dir; ///< Directory where the results are stored
@@ -67,6 +125,35 @@ private:
      */
     ClassProject::BDD_ID findBddId(unique_ID_t circuit_node);
 
+    /**
+     * \brief Computes the order in which the circuit inputs become variables
+     * \param circuit is the topologically sorted list of circuit nodes
+     * \return the circuit IDs of all INPUT nodes in variable order
+     *
+     *  OUTPUT nodes and the next-state inputs of flip flops are the roots of
+     *  the structural traversals; inputs no root depends on come last.
+     */
+    std::vector<unique_ID_t> ComputeInputOrder(const list_of_circuit_t &circuit) const;
+
+    /**
+     * \brief Moves the inputs listed in the order file to the front
+     * \param circuit is the topologically sorted list of circuit nodes
+     * \param order is the order computed by the heuristic
+     * \return the circuit IDs of all INPUT nodes in variable order
+     */
+    std::vector<unique_ID_t> ApplyOrderFile(const list_of_circuit_t &circuit,
+                                            const std::vector<unique_ID_t> &order) const;
+
+    /**
+     * \brief Releases the BDDs of circuit nodes whose readers are all processed
+     * \param circuit_node is the circuit node that has just been converted
+     * \return none
+     *
+     *  Once the unique table has doubled since the last collection, the dead
+     *  nodes are collected and all stored BDD IDs are remapped.
+     */
+    void releaseInputs(const circuit_node_t &circuit_node);
+
     /**
      * \brief Generates the BDD node equivalent to a variable with label "label".
      * \param label is label_t
@@ -0,0 +1,108 @@
+//
+// Parallel portfolio of variable-order strategies
+//
+
+#include "Portfolio.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+
+Portfolio::Portfolio(std::vector<PortfolioStrategy> strategies, size_t node_budget, double time_budget)
+        : node_budget(node_budget), time_budget(time_budget) {
+    for (auto &strategy : strategies) {
+        workers.push_back(Worker{std::move(strategy), nullptr, nullptr, "not run"});
+    }
+}
+
+
+std::vector<PortfolioStrategy> Portfolio::DefaultStrategies() {
+    return {
+        {"topological", InputOrder::Topological, false},
+        {"dfs", InputOrder::DepthFirst, false},
+        {"fanout", InputOrder::FanoutWeight, false},
+        {"dfs+sifting", InputOrder::DepthFirst, true},
+    };
+}
+
+
+bool Portfolio::Run(const list_of_circuit_t &circuit) {
+    using clock = std::chrono::steady_clock;
+
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t running = workers.size();
+    bool solved = false;
+
+    const auto start = clock::now();
+    const size_t nodes_per_worker = node_budget / std::max<size_t>(workers.size(), 1);
+    cancel = false;
+
+    for (auto &worker : workers) {
+        worker.manager = make_shared<ClassProject::Manager>();
+        worker.manager->setNodeLimit(nodes_per_worker);
+        worker.manager->setAbortFlag(&cancel);
+        worker.manager->setAutoReorder(worker.strategy.reorder);
+        worker.manager->setThreadCount(thread_count);
+        worker.manager->setBreadthFirst(breadth_first);
+        worker.converter = make_unique<CircuitToBDD>(worker.manager);
+        worker.converter->SetInputOrder(worker.strategy.input_order);
+        if (!input_order_file.empty()) {
+            worker.converter->SetInputOrderFile(input_order_file);
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            Worker &worker = workers[i];
+            std::ostringstream outcome;
+            bool finished = false;
+            try {
+                worker.converter->BuildBDD(circuit);
+                finished = true;
+                std::chrono::duration<double> elapsed = clock::now() - start;
+                outcome << "finished after " << elapsed.count() << " s with "
+                        << worker.manager->uniqueTableSize() << " nodes";
+            } catch (const std::exception &e) {
+                outcome << "stopped: " << e.what();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (finished && !solved) {
+                solved = true;
+                winner = i;
+                cancel = true;
+            }
+            worker.outcome = outcome.str();
+            --running;
+            done.notify_all();
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto finished = [&]() { return solved || running == 0; };
+        if (time_budget > 0) {
+            auto deadline = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(time_budget));
+            if (!done.wait_until(lock, deadline, finished)) cancel = true;
+        } else {
+            done.wait(lock, finished);
+        }
+    }
+    cancel = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    /* The winner's manager carries on without limits */
+    if (solved) {
+        workers[winner].manager->setAbortFlag(nullptr);
+        workers[winner].manager->setNodeLimit(0);
+    }
+    return solved;
+}
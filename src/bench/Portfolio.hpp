@@ -0,0 +1,111 @@
+//
+// Parallel portfolio of variable-order strategies
+//
+
+#pragma once
+
+#include "CircuitToBDD.hpp"
+#include "../Manager.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+ * \struct PortfolioStrategy
+ * \brief One way of building the BDDs: an input order heuristic, optionally with sifting
+ */
+struct PortfolioStrategy {
+    std::string name;
+    InputOrder input_order;
+    bool reorder;
+};
+
+
+/**
+ * \class Portfolio
+ *
+ * \brief Builds the same circuit with several strategies in parallel, first to finish wins
+ *
+ *  Every strategy gets its own thread, Manager and CircuitToBDD; the parsed
+ *  circuit is shared read-only. The node budget is split evenly over the
+ *  strategies, the time budget applies to the whole run. As soon as one
+ *  strategy finishes, the others are cancelled through the managers' abort
+ *  flag.
+ */
+class Portfolio {
+
+public:
+
+    /**
+     * \param strategies are the strategies to race
+     * \param node_budget is the total number of nodes of all managers, 0 for no limit
+     * \param time_budget is the wall-clock limit in seconds, 0 for no limit
+     */
+    Portfolio(std::vector<PortfolioStrategy> strategies, size_t node_budget, double time_budget);
+
+    /**
+     * \brief The default race: every input order heuristic, and the depth-first one with sifting
+     */
+    static std::vector<PortfolioStrategy> DefaultStrategies();
+
+    /**
+     * \brief Worker threads of the parallel apply in every strategy's manager
+     */
+    void SetThreadCount(size_t count) { thread_count = count; }
+
+    /**
+     * \brief Level-by-level apply in every strategy's manager
+     */
+    void SetBreadthFirst(bool enable) { breadth_first = enable; }
+
+    /**
+     * \brief Variable order file every strategy starts from, see CircuitToBDD::SetInputOrderFile
+     *
+     *  The inputs missing from the file still follow the strategy's heuristic.
+     */
+    void SetInputOrderFile(const std::string &order_file) { input_order_file = order_file; }
+
+    /**
+     * \brief Runs all strategies on the circuit and waits for the winner or the time budget
+     * \param Topologically sorted list containing the circuit nodes
+     * \return true if a strategy finished within the budget
+     */
+    bool Run(const list_of_circuit_t &circuit);
+
+    size_t GetWinner() const { return winner; }
+    size_t GetNumberOfStrategies() const { return workers.size(); }
+    const PortfolioStrategy &GetStrategy(size_t index) const { return workers[index].strategy; }
+
+    /**
+     * \brief Human readable result of a strategy: finish time and size, or why it stopped
+     */
+    const std::string &GetOutcome(size_t index) const { return workers[index].outcome; }
+
+    shared_ptr<ClassProject::Manager> GetManager(size_t index) const { return workers[index].manager; }
+
+    /**
+     * \brief Hands over the converter of a strategy, e.g. to write the winner's results
+     */
+    std::unique_ptr<CircuitToBDD> TakeConverter(size_t index) { return std::move(workers[index].converter); }
+
+private:
+
+    struct Worker {
+        PortfolioStrategy strategy;
+        shared_ptr<ClassProject::Manager> manager;
+        std::unique_ptr<CircuitToBDD> converter;
+        std::string outcome;
+    };
+
+    std::vector<Worker> workers;
+    size_t node_budget;
+    double time_budget;
+    size_t thread_count = 1;
+    bool breadth_first = false;
+    std::string input_order_file;   ///< Empty if none
+
+    std::atomic<bool> cancel{false};    ///< Abort flag shared by all managers
+    size_t winner = 0;
+};
@@ -0,0 +1,365 @@
+//
+// Symbolic reachability analysis of sequential circuits
+//
+
+#include "Reachability.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+using ClassProject::BDD_ID;
+
+
+namespace {
+
+    /// Fraction of all assignments that satisfy f
+    double Density(ClassProject::Manager &manager, BDD_ID f, std::unordered_map<BDD_ID, double> &done) {
+        if (f == manager.True()) return 1.0;
+        if (f == manager.False()) return 0.0;
+        auto it = done.find(f);
+        if (it != done.end()) return it->second;
+        double density = 0.5 * (Density(manager, manager.coFactorTrue(f), done) +
+                                Density(manager, manager.coFactorFalse(f), done));
+        done.emplace(f, density);
+        return density;
+    }
+
+}
+
+
+Reachability::Reachability(shared_ptr<ClassProject::Manager> manager_p, const list_of_circuit_t &circuit,
+                           ReachMode mode, size_t cluster_size)
+        : manager(std::move(manager_p)), mode(mode) {
+    /* Flip flop Q appears as an INPUT gate Q and a DFF gate Q reading D */
+    std::unordered_map<label_t, unique_ID_t> latch_input_of;
+    for (const auto &circuit_node : circuit) {
+        if (circuit_node.gate_type == FLIP_FLOP_GATE_T) {
+            latch_input_of[circuit_node.label] = *circuit_node.input_id_list.begin();
+        }
+    }
+
+    /* Primary inputs first, then every current-state variable directly above its next-state variable
+     * (and the middle one of iterative squaring) */
+    std::unordered_map<unique_ID_t, BDD_ID> values;
+    for (const auto &circuit_node : circuit) {
+        if (circuit_node.gate_type == INPUT_GATE_T && latch_input_of.count(circuit_node.label) == 0) {
+            values[circuit_node.id] = manager->createVar(circuit_node.label);
+            input_vars.push_back(values[circuit_node.id]);
+        }
+    }
+    std::vector<unique_ID_t> latch_inputs;
+    for (const auto &circuit_node : circuit) {
+        auto latch = latch_input_of.find(circuit_node.label);
+        if (circuit_node.gate_type != INPUT_GATE_T || latch == latch_input_of.end()) continue;
+
+        values[circuit_node.id] = manager->createVar(circuit_node.label);
+        current_vars.push_back(values[circuit_node.id]);
+        next_vars.push_back(manager->createVar(circuit_node.label + "'"));
+        if (mode == ReachMode::IterativeSquaring) {
+            middle_vars.push_back(manager->createVar(circuit_node.label + "''"));
+        }
+        latch_of_var[current_vars.back()] = latch_labels.size();
+        next_to_current[next_vars.back()] = current_vars.back();
+        latch_labels.push_back(circuit_node.label);
+        latch_inputs.push_back(latch->second);
+    }
+
+    BuildNextState(circuit, values, latch_inputs);
+    BuildClusters(cluster_size);
+
+    initial = manager->True();
+    for (size_t latch = latch_labels.size(); latch-- > 0;) {
+        initial = manager->and2(initial, manager->neg(current_vars[latch]));
+    }
+    reached = frontier = initial;
+    closure = current_cube = middle_cube = manager->True();
+    if (mode == ReachMode::IterativeSquaring) {
+        current_cube = Cube(current_vars);
+        middle_cube = Cube(middle_vars);
+        closure = StepRelation();
+    }
+    CollectGarbage();
+}
+
+
+void Reachability::BuildNextState(const list_of_circuit_t &circuit,
+                                  std::unordered_map<unique_ID_t, BDD_ID> &values,
+                                  const std::vector<unique_ID_t> &latch_inputs) {
+    auto fold = [&](const set_of_circuit_t &inputs, BDD_ID (ClassProject::Manager::*op)(BDD_ID, BDD_ID)) {
+        auto it = inputs.begin();
+        BDD_ID result = values.at(*it);
+        for (++it; it != inputs.end(); ++it) {
+            result = ((*manager).*op)(result, values.at(*it));
+        }
+        return result;
+    };
+
+    for (const auto &circuit_node : circuit) {
+        const set_of_circuit_t &inputs = circuit_node.input_id_list;
+        if (circuit_node.gate_type == NOT_GATE_T) {
+            values[circuit_node.id] = manager->neg(values.at(*inputs.begin()));
+        } else if (circuit_node.gate_type == BUFFER_GATE_T) {
+            values[circuit_node.id] = values.at(*inputs.begin());
+        } else if (circuit_node.gate_type == AND_GATE_T) {
+            values[circuit_node.id] = fold(inputs, &ClassProject::Manager::and2);
+        } else if (circuit_node.gate_type == OR_GATE_T) {
+            values[circuit_node.id] = fold(inputs, &ClassProject::Manager::or2);
+        } else if (circuit_node.gate_type == NAND_GATE_T) {
+            values[circuit_node.id] = manager->neg(fold(inputs, &ClassProject::Manager::and2));
+        } else if (circuit_node.gate_type == NOR_GATE_T) {
+            values[circuit_node.id] = manager->neg(fold(inputs, &ClassProject::Manager::or2));
+        } else if (circuit_node.gate_type == XOR_GATE_T) {
+            values[circuit_node.id] = fold(inputs, &ClassProject::Manager::xor2);
+        }
+    }
+
+    for (const auto input : latch_inputs) {
+        next_state.push_back(values.at(input));
+    }
+}
+
+
+void Reachability::BuildClusters(size_t cluster_size) {
+    /* Inputs and current-state variables are quantified, next-state variables stay */
+    std::set<BDD_ID> quantifiable(input_vars.begin(), input_vars.end());
+    quantifiable.insert(current_vars.begin(), current_vars.end());
+
+    std::vector<BDD_ID> conjuncts;
+    std::vector<std::set<BDD_ID>> supports;
+    std::unordered_map<BDD_ID, size_t> occurrences;  // quantifiable variable -> conjuncts left that depend on it
+    for (size_t latch = 0; latch < next_state.size(); ++latch) {
+        conjuncts.push_back(manager->xnor2(next_vars[latch], next_state[latch]));
+        supports.emplace_back();
+        manager->findVars(conjuncts.back(), supports.back());
+        for (const auto var : supports.back()) {
+            if (quantifiable.count(var) != 0) ++occurrences[var];
+        }
+    }
+
+    /* Greedy order: most variables freed for quantification, then fewest new variables */
+    std::vector<size_t> order;
+    std::vector<bool> picked(conjuncts.size(), false);
+    std::set<BDD_ID> introduced;
+    while (order.size() < conjuncts.size()) {
+        size_t best = conjuncts.size(), best_freed = 0, best_added = 0;
+        for (size_t c = 0; c < conjuncts.size(); ++c) {
+            if (picked[c]) continue;
+            size_t freed = 0, added = 0;
+            for (const auto var : supports[c]) {
+                if (quantifiable.count(var) != 0 && occurrences[var] == 1) ++freed;
+                if (introduced.count(var) == 0) ++added;
+            }
+            if (best == conjuncts.size() || freed > best_freed || (freed == best_freed && added < best_added)) {
+                best = c;
+                best_freed = freed;
+                best_added = added;
+            }
+        }
+        picked[best] = true;
+        order.push_back(best);
+        for (const auto var : supports[best]) {
+            if (quantifiable.count(var) != 0) --occurrences[var];
+            introduced.insert(var);
+        }
+    }
+
+    /* Consecutive conjuncts share a cluster while it stays small enough */
+    clusters.clear();
+    for (const auto c : order) {
+        if (!clusters.empty()) {
+            BDD_ID merged = manager->and2(clusters.back().relation, conjuncts[c]);
+            if (cluster_size == 0 || CountNodes(merged) <= cluster_size) {
+                clusters.back().relation = merged;
+                ++clusters.back().conjuncts;
+                continue;
+            }
+        }
+        clusters.push_back(ReachCluster{conjuncts[c], manager->True(), 1, 0, 0, 0});
+    }
+
+    /* Every variable is quantified after the last cluster that depends on it */
+    std::unordered_map<BDD_ID, size_t> last;
+    for (size_t j = 0; j < clusters.size(); ++j) {
+        std::set<BDD_ID> support;
+        manager->findVars(clusters[j].relation, support);
+        for (const auto var : support) {
+            if (quantifiable.count(var) != 0) last[var] = j;
+        }
+        clusters[j].nodes = CountNodes(clusters[j].relation);
+        clusters[j].support = support.size();
+    }
+    early_cube = manager->True();
+    for (const auto var : quantifiable) {
+        auto it = last.find(var);
+        if (it == last.end()) {
+            early_cube = manager->and2(early_cube, var);
+        } else {
+            clusters[it->second].cube = manager->and2(clusters[it->second].cube, var);
+            ++clusters[it->second].quantified;
+        }
+    }
+}
+
+
+bool Reachability::Run(size_t max_steps) {
+    return mode == ReachMode::IterativeSquaring ? RunSquaring(max_steps) : RunBreadthFirst(max_steps);
+}
+
+
+bool Reachability::RunBreadthFirst(size_t max_steps) {
+    using clock = std::chrono::steady_clock;
+
+    for (size_t step = 0; max_steps == 0 || step < max_steps; ++step) {
+        const auto start = clock::now();
+        ReachStep stats{};
+
+        /* Any set between the frontier and the reached set will do, take the smallest BDD */
+        const BDD_ID minimized = manager->minimize(frontier, manager->or2(frontier, manager->neg(reached)));
+        const size_t minimized_nodes = CountNodes(minimized), reached_nodes = CountNodes(reached);
+        const BDD_ID from = reached_nodes < minimized_nodes ? reached : minimized;
+        stats.frontier_nodes = CountNodes(frontier);
+        stats.from_nodes = std::min(minimized_nodes, reached_nodes);
+        stats.peak_nodes = manager->uniqueTableSize();
+
+        const BDD_ID image = Image(from, stats);
+        const BDD_ID new_states = manager->and2(image, manager->neg(reached));
+        reached = manager->or2(reached, new_states);
+        frontier = new_states;
+        stats.peak_nodes = std::max(stats.peak_nodes, manager->uniqueTableSize());
+
+        stats.image_nodes = CountNodes(image);
+        stats.new_nodes = CountNodes(new_states);
+        stats.reached_nodes = CountNodes(reached);
+        stats.seconds = std::chrono::duration<double>(clock::now() - start).count();
+        steps.push_back(stats);
+
+        CollectGarbage();
+        if (new_states == manager->False()) return true;
+    }
+    return false;
+}
+
+
+bool Reachability::RunSquaring(size_t max_steps) {
+    using clock = std::chrono::steady_clock;
+
+    std::map<BDD_ID, BDD_ID> next_to_middle, current_to_middle;
+    for (size_t latch = 0; latch < current_vars.size(); ++latch) {
+        next_to_middle[next_vars[latch]] = middle_vars[latch];
+        current_to_middle[current_vars[latch]] = middle_vars[latch];
+    }
+    for (size_t step = 0; max_steps == 0 || step < max_steps; ++step) {
+        const auto start = clock::now();
+        ReachStep stats{};
+        stats.from_nodes = stats.frontier_nodes = CountNodes(closure);
+        stats.peak_nodes = manager->uniqueTableSize();
+
+        /* R(Q, Q') = exists Q''. R(Q, Q'') * R(Q'', Q') */
+        const BDD_ID first = manager->permute(closure, next_to_middle);
+        const BDD_ID second = manager->permute(closure, current_to_middle);
+        stats.peak_nodes = std::max(stats.peak_nodes, manager->uniqueTableSize());
+        const BDD_ID squared = manager->andExists(first, second, middle_cube);
+        stats.product_nodes = CountNodes(squared);
+        stats.peak_nodes = std::max(stats.peak_nodes, manager->uniqueTableSize());
+
+        /* All states within the steps now covered */
+        const BDD_ID states = manager->permute(manager->andExists(initial, squared, current_cube), next_to_current);
+        const BDD_ID new_states = manager->and2(states, manager->neg(reached));
+        reached = manager->or2(reached, new_states);
+        frontier = new_states;
+        const bool fixed_point = new_states == manager->False() || squared == closure;
+        closure = squared;
+        stats.peak_nodes = std::max(stats.peak_nodes, manager->uniqueTableSize());
+
+        stats.image_nodes = stats.product_nodes;
+        stats.new_nodes = CountNodes(new_states);
+        stats.reached_nodes = CountNodes(reached);
+        stats.seconds = std::chrono::duration<double>(clock::now() - start).count();
+        steps.push_back(stats);
+
+        CollectGarbage();
+        if (fixed_point) return true;
+    }
+    return false;
+}
+
+
+BDD_ID Reachability::Image(BDD_ID states, ReachStep &stats) {
+    BDD_ID next = manager->exists(states, early_cube);
+    for (const auto &cluster : clusters) {
+        next = manager->andExists(next, cluster.relation, cluster.cube);
+        stats.product_nodes = std::max(stats.product_nodes, CountNodes(next));
+        stats.peak_nodes = std::max(stats.peak_nodes, manager->uniqueTableSize());
+    }
+
+    const BDD_ID image = manager->permute(next, next_to_current);
+    stats.peak_nodes = std::max(stats.peak_nodes, manager->uniqueTableSize());
+    return image;
+}
+
+
+BDD_ID Reachability::StepRelation() {
+    /* The inputs are quantified cluster by cluster, the current state stays */
+    BDD_ID relation = manager->True();
+    for (const auto &cluster : clusters) {
+        relation = manager->andExists(relation, cluster.relation, manager->exists(cluster.cube, current_cube));
+    }
+
+    /* Staying put makes R cover all paths up to its length */
+    BDD_ID identity = manager->True();
+    for (size_t latch = current_vars.size(); latch-- > 0;) {
+        identity = manager->and2(identity, manager->xnor2(current_vars[latch], next_vars[latch]));
+    }
+    return manager->or2(relation, identity);
+}
+
+
+BDD_ID Reachability::Cube(const std::vector<BDD_ID> &vars) {
+    BDD_ID cube = manager->True();
+    for (auto it = vars.rbegin(); it != vars.rend(); ++it) {
+        cube = manager->and2(cube, *it);
+    }
+    return cube;
+}
+
+
+bool Reachability::IsReachable(const std::vector<bool> &state) {
+    if (state.size() != current_vars.size()) {
+        throw std::invalid_argument("A state needs one value per flip flop");
+    }
+    BDD_ID f = reached;
+    while (!manager->isConstant(f)) {
+        f = state[latch_of_var.at(manager->topVar(f))] ? manager->coFactorTrue(f) : manager->coFactorFalse(f);
+    }
+    return f == manager->True();
+}
+
+
+double Reachability::CountStates() {
+    std::unordered_map<BDD_ID, double> done;
+    return std::ldexp(Density(*manager, reached, done), static_cast<int>(current_vars.size()));
+}
+
+
+size_t Reachability::CountNodes(BDD_ID f) {
+    std::set<BDD_ID> nodes;
+    manager->findNodes(f, nodes);
+    return nodes.size();
+}
+
+
+void Reachability::CollectGarbage() {
+    if (manager->uniqueTableSize() < gc_threshold) return;
+
+    std::vector<BDD_ID> roots = next_state;
+    for (const auto &cluster : clusters) {
+        roots.push_back(cluster.relation);
+        roots.push_back(cluster.cube);
+    }
+    roots.insert(roots.end(), {early_cube, initial, reached, frontier, closure, current_cube, middle_cube});
+    manager->collectGarbage(roots);
+    gc_threshold = std::max(GC_MIN_NODES, 2 * manager->uniqueTableSize());
+}
@@ -0,0 +1,202 @@
+//
+// Symbolic reachability analysis of sequential circuits
+//
+
+#pragma once
+
+#include "BenchParser.hpp"
+#include "../Manager.h"
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * \brief How the reachable states are computed
+ */
+enum class ReachMode {
+    BreadthFirst,       ///< one image step per distance from the initial state
+    IterativeSquaring   ///< squares the transitive closure of the transition relation
+};
+
+
+/**
+ * \struct ReachStep
+ * \brief Statistics of one image step, or of one squaring step
+ */
+struct ReachStep {
+    size_t frontier_nodes;  ///< nodes of the states found in the previous step, before simplification
+    size_t from_nodes;      ///< nodes of the set whose image was taken, or of the closure before squaring
+    size_t image_nodes;     ///< nodes of the image, or of the closure after squaring
+    size_t reached_nodes;   ///< nodes of the reached set after the step
+    size_t new_nodes;       ///< nodes of the states not reached before
+    size_t product_nodes;   ///< largest intermediate product of the relational products
+    size_t peak_nodes;      ///< largest unique table seen during the step, garbage included
+    double seconds;
+};
+
+
+/**
+ * \struct ReachCluster
+ * \brief One part of the partitioned transition relation
+ */
+struct ReachCluster {
+    ClassProject::BDD_ID relation;  ///< conjunction of the next-state constraints of some flip flops
+    ClassProject::BDD_ID cube;      ///< variables quantified right after conjoining this cluster
+    size_t conjuncts;               ///< number of flip flops in the cluster
+    size_t nodes;
+    size_t support;                 ///< number of variables the relation depends on
+    size_t quantified;              ///< number of variables in cube
+};
+
+
+/**
+ * \class Reachability
+ *
+ * \brief Reachable states of a sequential circuit by breadth-first image iteration
+ *
+ *  The parser splits every flip flop Q = DFF(D) into an INPUT gate Q and a
+ *  DFF gate reading D. Q becomes a current-state variable, followed directly
+ *  by a next-state variable Q'; the primary inputs come before all of them.
+ *  The next-state function of Q is the BDD of D, and the transition relation
+ *  is the conjunction of Q' == D over all flip flops. All flip flops start
+ *  at 0, as in the ISCAS89 benchmarks.
+ *
+ *  The relation is never built as a whole. Its conjuncts are ordered so
+ *  that inputs and current-state variables stop occurring as early as
+ *  possible: the next one is always the conjunct that leaves the most
+ *  variables to no other remaining conjunct, then the one that brings in
+ *  the fewest new variables (IWLS95 style). Consecutive conjuncts are then
+ *  merged into clusters as long as a cluster stays within the size
+ *  threshold.
+ *
+ *  An image step conjoins the clusters in this order to the set of states
+ *  with one relational product each, quantifying every input and
+ *  current-state variable right after the last cluster that depends on
+ *  it. Renaming next-state to current-state variables completes the step.
+ *  Every set between the states found in the last step and the whole
+ *  reached set has the same new successors, so the image is taken of the
+ *  smallest one at hand (frontier simplification): the new states
+ *  minimized with the states reached before as don't cares, or the reached
+ *  set itself.
+ *
+ *  Iterative squaring instead needs a third copy Q'' of every flip flop,
+ *  placed below Q'. It starts from the relation R(Q, Q') of at most one
+ *  step, the inputs quantified and the identity added, and squares it as
+ *  R(Q, Q') = exists Q''. R(Q, Q'') * R(Q'', Q'), which doubles the number
+ *  of steps covered. After every squaring the states reachable from the
+ *  initial state are derived from R; once they stop growing, nothing is
+ *  left to find. The number of steps is logarithmic in the sequential
+ *  depth, but the closure is often much larger than any reached set.
+ */
+class Reachability {
+
+public:
+
+    static constexpr size_t DEFAULT_CLUSTER_SIZE = 5000;   ///< nodes
+
+    /**
+     * \param manager gets the variables and must not have any yet
+     * \param circuit is the topologically sorted circuit from BenchParser
+     * \param mode selects the algorithm used by Run()
+     * \param cluster_size is the largest cluster in nodes, 0 for a single cluster (monolithic relation)
+     */
+    Reachability(shared_ptr<ClassProject::Manager> manager, const list_of_circuit_t &circuit,
+                 ReachMode mode = ReachMode::BreadthFirst, size_t cluster_size = DEFAULT_CLUSTER_SIZE);
+
+    /**
+     * \brief Takes image or squaring steps until no new state appears
+     * \param max_steps stops after this many steps, 0 for no limit
+     * \return true if the fixed point was reached
+     */
+    bool Run(size_t max_steps = 0);
+
+    /**
+     * \brief Whether a state is in the reached set
+     * \param state holds one value per flip flop, in the order of GetLatchLabels()
+     * \return bool
+     *
+     *  Follows a single path of the reached set, so it costs at most one
+     *  step per flip flop.
+     */
+    bool IsReachable(const std::vector<bool> &state);
+
+    /**
+     * \brief Number of states in the reached set
+     */
+    double CountStates();
+
+    const std::vector<label_t> &GetLatchLabels() const { return latch_labels; }
+    size_t GetNumberOfInputs() const { return input_vars.size(); }
+    const std::vector<ReachCluster> &GetClusters() const { return clusters; }
+    ReachMode GetMode() const { return mode; }
+    const std::vector<ReachStep> &GetSteps() const { return steps; }
+    ClassProject::BDD_ID GetReached() const { return reached; }
+
+private:
+
+    shared_ptr<ClassProject::Manager> manager;
+    ReachMode mode;
+
+    std::vector<label_t> latch_labels;
+    std::vector<ClassProject::BDD_ID> input_vars;
+    std::vector<ClassProject::BDD_ID> current_vars;    ///< per flip flop
+    std::vector<ClassProject::BDD_ID> next_vars;       ///< per flip flop
+    std::vector<ClassProject::BDD_ID> middle_vars;     ///< per flip flop, for iterative squaring only
+    std::vector<ClassProject::BDD_ID> next_state;      ///< next-state function per flip flop
+    std::unordered_map<ClassProject::BDD_ID, size_t> latch_of_var;     ///< current-state variable -> flip flop
+    std::map<ClassProject::BDD_ID, ClassProject::BDD_ID> next_to_current;   ///< variable renaming
+
+    std::vector<ReachCluster> clusters;   ///< partitioned transition relation, in schedule order
+    ClassProject::BDD_ID early_cube;      ///< inputs and current-state variables no cluster depends on
+    ClassProject::BDD_ID initial;
+    ClassProject::BDD_ID reached;
+    ClassProject::BDD_ID frontier;        ///< states found in the last step
+    ClassProject::BDD_ID closure;         ///< pairs of states connected within the steps squared so far
+    ClassProject::BDD_ID current_cube;    ///< current-state variables, for iterative squaring only
+    ClassProject::BDD_ID middle_cube;     ///< middle variables, for iterative squaring only
+
+    std::vector<ReachStep> steps;
+
+    static constexpr size_t GC_MIN_NODES = 1 << 17; ///< Unique table size that first triggers a garbage collection
+    size_t gc_threshold = GC_MIN_NODES;
+
+    /**
+     * \brief Builds the BDD of every gate and keeps those of the flip flop inputs
+     * \param values holds the variable of every INPUT gate and receives the gates
+     * \param latch_inputs are the circuit IDs of the flip flop inputs D
+     */
+    void BuildNextState(const list_of_circuit_t &circuit,
+                        std::unordered_map<unique_ID_t, ClassProject::BDD_ID> &values,
+                        const std::vector<unique_ID_t> &latch_inputs);
+
+    /**
+     * \brief Orders the next-state constraints, clusters them and computes the quantification schedule
+     */
+    void BuildClusters(size_t cluster_size);
+
+    bool RunBreadthFirst(size_t max_steps);
+    bool RunSquaring(size_t max_steps);
+
+    /**
+     * \brief Successors of a set of states, as a set over current-state variables
+     */
+    ClassProject::BDD_ID Image(ClassProject::BDD_ID states, ReachStep &stats);
+
+    /**
+     * \brief Relation of at most one step over current- and next-state variables
+     */
+    ClassProject::BDD_ID StepRelation();
+
+    ClassProject::BDD_ID Cube(const std::vector<ClassProject::BDD_ID> &vars);
+
+    size_t CountNodes(ClassProject::BDD_ID f);
+
+    /**
+     * \brief Collects everything but the clusters, the fixed sets and the next-state functions
+     *
+     *  Only once the unique table has doubled since the last collection.
+     */
+    void CollectGarbage();
+};
@@ -9,38 +9,156 @@
 #include "Manager.h"
 #include "BenchParser.hpp"
 #include "CircuitToBDD.hpp"
+#include "Portfolio.hpp"
 #include "BenchmarkLib.h"
 
 int main(int argc, char *argv[]) {
 
     if (2 > argc) {
         std::cout << "Must specify a filename!" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <file.bench> [--reorder] [--order=topological|dfs|fanout]"
+                  << " [--order-file=<file>] [--export-order=<file>] [--threads=<n>] [--breadth-first]"
+                  << " [--portfolio [--budget-nodes=<n>] [--budget-seconds=<s>]]" << std::endl;
         return -1;
     }
 
     std::string bench_file = argv[1];
+    bool reorder = false;   // dynamic reordering by sifting while the BDD is built
+    InputOrder input_order = InputOrder::Topological;
+    bool order_chosen = false;  // --order or --reorder given, which the portfolio decides itself
+    std::string order_file;     // variable order to start from
+    std::string export_file;    // where to write the final variable order
+    size_t threads = 1;         // worker threads of the parallel apply
+    bool breadth_first = false; // level-by-level apply
+    bool portfolio = false;     // race all ordering strategies in parallel
+    size_t budget_nodes = 0;
+    double budget_seconds = 0;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--reorder") {
+            reorder = true;
+            order_chosen = true;
+        } else if (option == "--order=topological") {
+            input_order = InputOrder::Topological;
+            order_chosen = true;
+        } else if (option == "--order=dfs") {
+            input_order = InputOrder::DepthFirst;
+            order_chosen = true;
+        } else if (option == "--order=fanout") {
+            input_order = InputOrder::FanoutWeight;
+            order_chosen = true;
+        } else if (option.rfind("--order-file=", 0) == 0) {
+            order_file = option.substr(std::string("--order-file=").size());
+        } else if (option.rfind("--export-order=", 0) == 0) {
+            export_file = option.substr(std::string("--export-order=").size());
+        } else if (option.rfind("--threads=", 0) == 0) {
+            threads = std::stoul(option.substr(std::string("--threads=").size()));
+        } else if (option == "--breadth-first") {
+            breadth_first = true;
+        } else if (option == "--portfolio") {
+            portfolio = true;
+        } else if (option.rfind("--budget-nodes=", 0) == 0) {
+            budget_nodes = std::stoul(option.substr(std::string("--budget-nodes=").size()));
+        } else if (option.rfind("--budget-seconds=", 0) == 0) {
+            budget_seconds = std::stod(option.substr(std::string("--budget-seconds=").size()));
+        } else {
+            std::cout << "Unknown option: " << option << std::endl;
+            return -1;
+        }
+    }
+
+    if (portfolio && order_chosen) {
+        std::cout << "--order and --reorder cannot be combined with --portfolio, which races them" << std::endl;
+        return -1;
+    }
 
     /* Parse the circuit from file and generate topological sorted circuit */
     BenchParser parsed_circuit(bench_file);
+    const list_of_circuit_t circuit = parsed_circuit.GetSortedCircuit();
 
-    auto BDD_manager = make_shared<ClassProject::Manager>();
-    auto circuit2BDD = make_unique<CircuitToBDD>(BDD_manager);
+    shared_ptr<ClassProject::Manager> BDD_manager;
+    unique_ptr<CircuitToBDD> circuit2BDD;
 
     double user_time, vm1, rss1, vm2, rss2;
 
-    std::cout << "- Generating BDD from circuit...";
     process_mem_usage(vm1, rss1);
-    user_time = userTime();
-    circuit2BDD->GenerateBDD(parsed_circuit.GetSortedCircuit(), bench_file);
-    user_time = userTime() - user_time;
-    std::cout << " BDD generated successfully!" << std::endl << std::endl;
+    if (portfolio) {
+        Portfolio race(Portfolio::DefaultStrategies(), budget_nodes, budget_seconds);
+        race.SetThreadCount(threads);
+        race.SetBreadthFirst(breadth_first);
+        if (!order_file.empty()) {
+            race.SetInputOrderFile(order_file);
+        }
+
+        std::cout << "- Generating BDD from circuit with " << race.GetNumberOfStrategies() << " strategies...";
+        user_time = userTime();
+        bool solved = race.Run(circuit);
+        user_time = userTime() - user_time;
+        std::cout << std::endl << std::endl;
+
+        std::cout << "**** Portfolio ****" << std::endl;
+        for (size_t i = 0; i < race.GetNumberOfStrategies(); ++i) {
+            std::cout << " " << race.GetStrategy(i).name << ": " << race.GetOutcome(i) << std::endl;
+        }
+        if (!solved) {
+            std::cout << " No strategy finished within the budget" << std::endl;
+            return -1;
+        }
+        std::cout << " Winner: " << race.GetStrategy(race.GetWinner()).name << std::endl << std::endl;
+        reorder = race.GetStrategy(race.GetWinner()).reorder;
+
+        BDD_manager = race.GetManager(race.GetWinner());
+        circuit2BDD = race.TakeConverter(race.GetWinner());
+        circuit2BDD->WriteResults(circuit, bench_file);
+    } else {
+        BDD_manager = make_shared<ClassProject::Manager>();
+        circuit2BDD = make_unique<CircuitToBDD>(BDD_manager);
+        BDD_manager->setAutoReorder(reorder);
+        BDD_manager->setThreadCount(threads);
+        BDD_manager->setBreadthFirst(breadth_first);
+        circuit2BDD->SetInputOrder(input_order);
+        if (!order_file.empty()) {
+            circuit2BDD->SetInputOrderFile(order_file);
+        }
+
+        std::cout << "- Generating BDD from circuit...";
+        user_time = userTime();
+        circuit2BDD->GenerateBDD(circuit, bench_file);
+        user_time = userTime() - user_time;
+        std::cout << " BDD generated successfully!" << std::endl << std::endl;
+    }
 
     circuit2BDD->PrintBDD(parsed_circuit.GetListOfOutputLabels());
 
+    if (!export_file.empty()) {
+        BDD_manager->exportVariableOrder(export_file);
+    }
+
     std::cout << "**** Performance ****" << std::endl;
     std::cout << " Runtime: " << user_time << std::endl;
     process_mem_usage(vm2, rss2);
-    std::cout << " VM: " << vm2 - vm1 << "; RSS: " << rss2 - rss1 << endl << endl;
+    std::cout << " VM: " << vm2 - vm1 << "; RSS: " << rss2 - rss1 << "; peak RSS: " << peak_resident_set()
+              << endl << endl;
+
+    size_t lookups = BDD_manager->computedCacheLookups();
+    size_t hits = BDD_manager->computedCacheHits();
+    std::cout << "**** BDD Statistics ****" << std::endl;
+    std::cout << " Unique table nodes: " << BDD_manager->uniqueTableSize() << std::endl;
+    std::cout << " Computed table: " << BDD_manager->computedCacheSize() << " entries; lookups: " << lookups
+              << "; hits: " << hits << "; hit rate: "
+              << (lookups ? 100.0 * static_cast<double>(hits) / static_cast<double>(lookups) : 0.0) << "%"
+              << endl << endl;
+
+    if (reorder) {
+        const ClassProject::ReorderStats &stats = BDD_manager->getReorderStats();
+        std::cout << "**** Reordering ****" << std::endl;
+        std::cout << " Sifting runs: " << stats.runs << std::endl;
+        if (stats.runs > 0) {
+            std::cout << " Last run: " << stats.nodesBefore << " -> " << stats.nodesAfter << " nodes" << std::endl;
+        }
+        std::cout << std::endl;
+    }
 
     return 0;
 }
@@ -0,0 +1,170 @@
+//
+// Reachable states of a sequential .bench circuit
+//
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Manager.h"
+#include "BenchParser.hpp"
+#include "Reachability.hpp"
+#include "BenchmarkLib.h"
+
+namespace {
+
+    /// Outcome of one mode, for the comparison at the end
+    struct Summary {
+        std::string mode;
+        size_t steps;
+        bool fixed_point;
+        double states;
+        size_t peak_nodes;
+        size_t frontier_nodes;      // summed over the steps, before simplification
+        size_t from_nodes;          // summed over the steps, after simplification
+        double seconds;
+    };
+
+    Summary Analyze(const list_of_circuit_t &circuit, ReachMode mode, size_t cluster_size, size_t max_steps,
+                    bool print_steps, const std::vector<std::string> &queries) {
+        Summary summary{mode == ReachMode::IterativeSquaring ? "squaring" : "bfs", 0, false, 0, 0, 0, 0, 0};
+        std::cout << std::endl << "==== Mode: " << summary.mode << " ====" << std::endl;
+
+        auto BDD_manager = make_shared<ClassProject::Manager>();
+        double user_time = userTime();
+        Reachability reach(BDD_manager, circuit, mode, cluster_size);
+        double build_time = userTime() - user_time;
+
+        std::cout << "- " << reach.GetNumberOfInputs() << " inputs, " << reach.GetLatchLabels().size()
+                  << " flip flops" << std::endl;
+        std::cout << "- State bit order:";
+        for (const auto &label : reach.GetLatchLabels()) std::cout << " " << label;
+        std::cout << std::endl;
+        std::cout << "- Transition relation: " << reach.GetClusters().size() << " clusters, built in "
+                  << build_time << " s" << std::endl;
+
+        std::cout << std::endl << "**** Clusters ****" << std::endl;
+        for (size_t i = 0; i < reach.GetClusters().size(); ++i) {
+            const ReachCluster &cluster = reach.GetClusters()[i];
+            std::cout << " " << i + 1 << ": " << cluster.conjuncts << " flip flops; " << cluster.nodes
+                      << " nodes; support " << cluster.support << "; quantifies " << cluster.quantified << std::endl;
+        }
+
+        user_time = userTime();
+        summary.fixed_point = reach.Run(max_steps);
+        summary.seconds = userTime() - user_time;
+
+        const auto &steps = reach.GetSteps();
+        if (print_steps) {
+            std::cout << std::endl << (mode == ReachMode::IterativeSquaring ? "**** Squaring steps ****"
+                                                                            : "**** Image steps ****") << std::endl;
+        }
+        for (size_t i = 0; i < steps.size(); ++i) {
+            const ReachStep &step = steps[i];
+            summary.peak_nodes = std::max(summary.peak_nodes, step.peak_nodes);
+            summary.frontier_nodes += step.frontier_nodes;
+            summary.from_nodes += step.from_nodes;
+            if (!print_steps) continue;
+            std::cout << " " << i + 1 << ": ";
+            if (mode == ReachMode::BreadthFirst) std::cout << "frontier " << step.frontier_nodes << " nodes; ";
+            std::cout << "from " << step.from_nodes << " nodes; image " << step.image_nodes
+                      << "; new " << step.new_nodes << "; reached " << step.reached_nodes
+                      << "; largest product " << step.product_nodes << "; peak " << step.peak_nodes
+                      << "; time " << step.seconds << " s" << std::endl;
+        }
+        summary.steps = steps.size();
+        summary.states = reach.CountStates();
+        std::cout << std::endl;
+
+        std::cout << "**** Reachability ****" << std::endl;
+        std::cout << " Iterations: " << summary.steps << (summary.fixed_point ? " (fixed point)" : " (step limit)")
+                  << std::endl;
+        std::cout << " Reachable states: " << summary.states << std::endl;
+        std::cout << " Peak nodes: " << summary.peak_nodes << std::endl;
+        if (mode == ReachMode::BreadthFirst) {
+            std::cout << " Frontier nodes: " << summary.frontier_nodes << ", simplified to " << summary.from_nodes
+                      << " (all steps)" << std::endl;
+        }
+        std::cout << " Runtime: " << summary.seconds << std::endl;
+
+        for (const auto &query : queries) {
+            std::vector<bool> state;
+            for (char bit : query) state.push_back(bit == '1');
+            if (state.size() != reach.GetLatchLabels().size()) {
+                std::cout << " State " << query << ": needs " << reach.GetLatchLabels().size() << " values"
+                          << std::endl;
+                continue;
+            }
+            std::cout << " State " << query << ": " << (reach.IsReachable(state) ? "reachable" : "not reached")
+                      << std::endl;
+        }
+        return summary;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+
+    if (2 > argc) {
+        std::cout << "Must specify a filename!" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <file.bench> [--mode=bfs|squaring|both] [--max-steps=<n>]"
+                  << " [--cluster-size=<n>] [--monolithic] [--summary] [--state=<0|1 per flip flop>]..."
+                  << std::endl;
+        return -1;
+    }
+
+    std::string bench_file = argv[1];
+    std::vector<ReachMode> modes{ReachMode::BreadthFirst};
+    size_t max_steps = 0;               // steps before giving up, 0 for no limit
+    size_t cluster_size = Reachability::DEFAULT_CLUSTER_SIZE;   // 0 builds the monolithic relation
+    bool print_steps = true;            // one line per step
+    std::vector<std::string> queries;   // states to look up in the reached set
+
+    for (int i = 2; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--mode=bfs") {
+            modes = {ReachMode::BreadthFirst};
+        } else if (option == "--mode=squaring") {
+            modes = {ReachMode::IterativeSquaring};
+        } else if (option == "--mode=both") {
+            modes = {ReachMode::BreadthFirst, ReachMode::IterativeSquaring};
+        } else if (option.rfind("--max-steps=", 0) == 0) {
+            max_steps = std::stoul(option.substr(std::string("--max-steps=").size()));
+        } else if (option.rfind("--cluster-size=", 0) == 0) {
+            cluster_size = std::stoul(option.substr(std::string("--cluster-size=").size()));
+        } else if (option == "--monolithic") {
+            cluster_size = 0;
+        } else if (option == "--summary") {
+            print_steps = false;
+        } else if (option.rfind("--state=", 0) == 0) {
+            queries.push_back(option.substr(std::string("--state=").size()));
+        } else {
+            std::cout << "Unknown option: " << option << std::endl;
+            return -1;
+        }
+    }
+
+    BenchParser parsed_circuit(bench_file);
+    const list_of_circuit_t circuit = parsed_circuit.GetSortedCircuit();
+
+    std::vector<Summary> summaries;
+    for (const auto mode : modes) {
+        summaries.push_back(Analyze(circuit, mode, cluster_size, max_steps, print_steps, queries));
+    }
+
+    if (summaries.size() > 1) {
+        std::cout << std::endl << "**** Comparison ****" << std::endl;
+        for (const auto &summary : summaries) {
+            std::cout << " " << summary.mode << ": " << summary.steps << " steps"
+                      << (summary.fixed_point ? "" : " (step limit)") << "; " << summary.states << " states; peak "
+                      << summary.peak_nodes << " nodes; " << summary.seconds << " s" << std::endl;
+        }
+        if (summaries[0].fixed_point && summaries[1].fixed_point && summaries[0].states != summaries[1].states) {
+            std::cout << " MISMATCH in the number of reachable states" << std::endl;
+        }
+    }
+    std::cout << std::endl << " Peak RSS: " << peak_resident_set() << std::endl << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+//
+// Throughput of a thread-safe manager shared by several client threads
+//
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Manager.h"
+
+using ClassProject::BDD_ID;
+using ClassProject::Manager;
+
+namespace {
+
+    /// Function of the client's working set and the number of literals it was built from
+    struct Function {
+        BDD_ID id;
+        size_t leaves;
+    };
+
+    constexpr size_t POOL_SIZE = 32;
+    constexpr size_t MAX_LEAVES = 8;    // keeps every function small
+
+    /// One client: combines random members of its working set and queries the results
+    void client(Manager &manager, const std::vector<BDD_ID> &vars, size_t ops, unsigned seed) {
+        std::minstd_rand random(seed);
+        std::vector<Function> pool;
+        for (size_t i = 0; i < POOL_SIZE; ++i) pool.push_back({vars[random() % vars.size()], 1});
+
+        for (size_t n = 0; n < ops; ++n) {
+            Function &a = pool[random() % POOL_SIZE];
+            Function &b = pool[random() % POOL_SIZE];
+            Function &target = pool[random() % POOL_SIZE];
+            if (a.leaves + b.leaves > MAX_LEAVES) {
+                target = {vars[random() % vars.size()], 1};
+                continue;
+            }
+            BDD_ID result;
+            switch (random() % 4) {
+                case 0: result = manager.and2(a.id, b.id); break;
+                case 1: result = manager.or2(a.id, b.id); break;
+                case 2: result = manager.xor2(a.id, b.id); break;
+                default: result = manager.ite(vars[random() % vars.size()], a.id, b.id); break;
+            }
+            // the read paths that take no lock
+            if (!manager.isConstant(result)) {
+                manager.topVar(result);
+                manager.coFactorTrue(result);
+                manager.coFactorFalse(result);
+            }
+            target = {result, a.leaves + b.leaves};
+        }
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    size_t var_count = 24;
+    size_t ops = 200000;        // operations per round, split between the clients
+    size_t max_threads = 8;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option.rfind("--vars=", 0) == 0) {
+            var_count = std::stoul(option.substr(std::string("--vars=").size()));
+        } else if (option.rfind("--ops=", 0) == 0) {
+            ops = std::stoul(option.substr(std::string("--ops=").size()));
+        } else if (option.rfind("--max-threads=", 0) == 0) {
+            max_threads = std::stoul(option.substr(std::string("--max-threads=").size()));
+        } else {
+            std::cout << "Unknown option: " << option << std::endl;
+            std::cout << "Usage: " << argv[0] << " [--vars=<n>] [--ops=<n>] [--max-threads=<n>]" << std::endl;
+            return -1;
+        }
+    }
+    if (var_count == 0) var_count = 1;
+
+    std::cout << "- " << var_count << " shared variables, " << ops << " operations per round" << std::endl;
+    double base_rate = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        Manager manager;
+        manager.setThreadSafe(true, var_count);
+        std::vector<BDD_ID> vars;
+        for (size_t i = 0; i < var_count; ++i) vars.push_back(manager.createVar("x" + std::to_string(i)));
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> clients;
+        for (size_t t = 0; t < threads; ++t) {
+            size_t share = ops / threads + (t < ops % threads ? 1 : 0);
+            clients.emplace_back(client, std::ref(manager), std::cref(vars), share, static_cast<unsigned>(t + 1));
+        }
+        for (auto &c : clients) c.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double rate = ops / seconds;
+        if (threads == 1) base_rate = rate;
+        std::cout << "  threads: " << threads
+                  << "  time: " << seconds << " s"
+                  << "  ops/s: " << rate
+                  << "  speedup: " << rate / base_rate
+                  << "  unique table nodes: " << manager.uniqueTableSize() << std::endl;
+    }
+    return 0;
+}
@@ -3,7 +3,12 @@
 
 #include <gtest/gtest.h>
 #include "Manager.h"
+#include "CircuitToBDD.hpp"
+#include "Reachability.hpp"
 #include <fstream>
+#include <functional>
+#include <map>
+#include <thread>
 
 using namespace ClassProject;
 
@@ -32,7 +37,7 @@ TEST(ManagerBasicTest, TrueAndFalse) {
 
 TEST(ManagerBasicTest, InitialTableSize) {
     Manager mgr;
-    EXPECT_EQ(mgr.uniqueTableSize(), 2);
+    EXPECT_EQ(mgr.uniqueTableSize(), 1);   // single terminal, True = ~False
 }
 
 TEST(ManagerBasicTest, CreateVariable) {
@@ -40,7 +45,7 @@ TEST(ManagerBasicTest, CreateVariable) {
     BDD_ID a = mgr.createVar("a");
     BDD_ID b = mgr.createVar("b");
     EXPECT_NE(a, b);
-    EXPECT_EQ(mgr.uniqueTableSize(), 4);   // 0,1,a,b
+    EXPECT_EQ(mgr.uniqueTableSize(), 3);   // terminal,a,b
 }
 
 TEST(ManagerBasicTest, IsConstantAndVariable) {
@@ -144,6 +149,17 @@ TEST_F(ManagerTest, DoubleNeg) {
     EXPECT_EQ(nna, a);
 }
 
+TEST_F(ManagerTest, NegSharesNodes) {
+    BDD_ID f = manager.or2(manager.and2(a, b), c);
+    size_t before = manager.uniqueTableSize();
+
+    BDD_ID nf = manager.neg(f);
+    EXPECT_NE(nf, f);
+    EXPECT_EQ(manager.uniqueTableSize(), before);   // no new nodes for ~f
+    EXPECT_EQ(manager.coFactorTrue(nf),  manager.neg(manager.coFactorTrue(f)));
+    EXPECT_EQ(manager.coFactorFalse(nf), manager.neg(manager.coFactorFalse(f)));
+}
+
 
 // ---------------- Binary logic ops: and/or/xor/xnor ----------------
 
@@ -216,6 +232,21 @@ TEST_F(ManagerTest, CoFactorTrueFalseOnAnd) {
     EXPECT_TRUE(nodes.count(f_false));
 }
 
+TEST_F(ManagerTest, CoFactorBelowTopVariable) {
+    BDD_ID f = manager.or2(manager.and2(a, b), c);
+
+    EXPECT_EQ(manager.coFactorTrue(f, b), manager.or2(a, c));
+    EXPECT_EQ(manager.coFactorFalse(f, b), c);
+    EXPECT_EQ(manager.coFactorTrue(manager.neg(f), b), manager.nor2(a, c));
+    EXPECT_EQ(manager.coFactorFalse(manager.neg(f), b), manager.neg(c));
+    EXPECT_EQ(manager.coFactorTrue(f, d), f);     // d not in the support
+
+    // repeated cofactoring is answered from the computed table
+    size_t size = manager.uniqueTableSize();
+    EXPECT_EQ(manager.coFactorTrue(f, b), manager.or2(a, c));
+    EXPECT_EQ(manager.uniqueTableSize(), size);
+}
+
 // ---------------- ITE behavior ----------------
 
 TEST_F(ManagerTest, IteBasic) {
@@ -230,6 +261,76 @@ TEST_F(ManagerTest, IteActsLikeVariable) {
     EXPECT_EQ(res, a);
 }
 
+TEST_F(ManagerTest, IteStandardTriplesShareCacheEntries) {
+    BDD_ID f = manager.or2(a, c);
+    BDD_ID g = manager.xor2(b, d);
+
+    BDD_ID fg = manager.ite(f, g, manager.False());
+    size_t hits = manager.computedCacheHits();
+
+    EXPECT_EQ(manager.ite(g, f, manager.False()), fg);       // commuted AND
+    EXPECT_EQ(manager.ite(f, g, f), fg);                     // e == i becomes 0
+    EXPECT_EQ(manager.ite(manager.neg(f), manager.False(), g), fg);
+    EXPECT_EQ(manager.ite(f, manager.neg(g), manager.True()), manager.neg(fg));
+    EXPECT_EQ(manager.computedCacheHits(), hits + 4);        // all answered from the table
+}
+
+TEST_F(ManagerTest, IteReplacesOperandsEqualToCondition) {
+    BDD_ID f = manager.and2(a, b);
+    EXPECT_EQ(manager.ite(f, f, c), manager.or2(f, c));
+    EXPECT_EQ(manager.ite(f, manager.neg(f), c), manager.and2(manager.neg(f), c));
+    EXPECT_EQ(manager.ite(f, c, manager.neg(f)), manager.or2(manager.neg(f), c));
+    EXPECT_EQ(manager.ite(f, f, manager.neg(f)), manager.True());
+}
+
+TEST_F(ManagerTest, ApplyKernelsMatchIte) {
+    BDD_ID f = manager.or2(manager.and2(a, b), c);
+    BDD_ID g = manager.xor2(b, manager.neg(d));
+    BDD_ID nf = manager.neg(f), ng = manager.neg(g);
+
+    EXPECT_EQ(manager.and2(f, g), manager.ite(f, g, manager.False()));
+    EXPECT_EQ(manager.or2(f, g), manager.ite(f, manager.True(), g));
+    EXPECT_EQ(manager.xor2(f, g), manager.ite(f, ng, g));
+    EXPECT_EQ(manager.nand2(f, g), manager.ite(f, ng, manager.True()));
+    EXPECT_EQ(manager.nor2(f, g), manager.ite(f, manager.False(), ng));
+    EXPECT_EQ(manager.xnor2(f, g), manager.ite(f, g, ng));
+    EXPECT_EQ(manager.xor2(nf, g), manager.xnor2(f, g));
+}
+
+TEST_F(ManagerTest, XorOperandOrderSharesCacheEntry) {
+    BDD_ID f = manager.and2(a, c);
+    BDD_ID g = manager.or2(b, d);
+    BDD_ID fg = manager.xor2(f, g);
+    size_t hits = manager.computedCacheHits();
+
+    EXPECT_EQ(manager.xor2(g, f), fg);
+    EXPECT_EQ(manager.xor2(manager.neg(g), manager.neg(f)), fg);
+    EXPECT_EQ(manager.computedCacheHits(), hits + 2);
+}
+
+TEST(DeepBddTest, ApplyDepthIsNotLimitedByCallStack) {
+    ClassProject::Manager m;
+    const size_t n = 200000;
+    std::vector<BDD_ID> vars;
+    for (size_t k = 0; k < n; ++k) vars.push_back(m.createVar("x" + std::to_string(k)));
+
+    // Built bottom-up, each step only touches the top node
+    BDD_ID conj = m.True(), disj = m.False();
+    for (size_t k = n; k-- > 0;) {
+        conj = m.and2(vars[k], conj);
+        disj = m.or2(vars[k], disj);
+    }
+
+    // Operands share no structure below the top, so this descends all n levels
+    BDD_ID x = m.xor2(conj, disj);
+    EXPECT_EQ(m.coFactorTrue(m.coFactorFalse(x, vars[0]), vars[n - 1]), m.True());
+    EXPECT_EQ(m.and2(x, conj), m.False());
+
+    std::set<BDD_ID> nodes;
+    m.findNodes(conj, nodes);
+    EXPECT_EQ(nodes.size(), n + 2);
+}
+
 // ---------------- Structure: nodes and vars ----------------
 
 TEST_F(ManagerTest, FindNodesSingleVar) {
@@ -266,6 +367,883 @@ TEST_F(ManagerTest, DeMorgan) {
     EXPECT_EQ(lhs, rhs);
 }
 
+// ---------------- Unique table ----------------
+
+TEST(ManagerBasicTest, UniqueTableStaysCanonicalAcrossRehash) {
+    Manager mgr;
+    std::vector<BDD_ID> vars;
+    for (int i = 0; i < 64; ++i) vars.push_back(mgr.createVar("x" + std::to_string(i)));
+
+    // enough nodes to grow the bucket array several times
+    std::vector<BDD_ID> funcs;
+    for (size_t i = 0; i + 1 < vars.size(); ++i) {
+        for (size_t j = i + 1; j < vars.size(); ++j) funcs.push_back(mgr.and2(vars[i], vars[j]));
+    }
+    size_t size = mgr.uniqueTableSize();
+    EXPECT_GT(size, 2048u);
+
+    size_t k = 0;
+    for (size_t i = 0; i + 1 < vars.size(); ++i) {
+        for (size_t j = i + 1; j < vars.size(); ++j) EXPECT_EQ(mgr.and2(vars[j], vars[i]), funcs[k++]);
+    }
+    EXPECT_EQ(mgr.uniqueTableSize(), size);
+}
+
+TEST(ManagerBasicTest, CompactNodeLayout) {
+    EXPECT_EQ(sizeof(BDDNode), VDS_NODE_REF_BITS == 64 ? 32u : 16u);
+
+    Manager mgr;
+    BDD_ID a = mgr.createVar("a");
+    BDD_ID b = mgr.createVar("b");
+    BDD_ID f = mgr.or2(a, b);
+    EXPECT_EQ(mgr.getTopVarName(f), "a");
+    EXPECT_EQ(mgr.getTopVarName(mgr.coFactorFalse(f)), "b");
+    EXPECT_EQ(mgr.topVar(mgr.coFactorFalse(f)), b);
+}
+
+// ---------------- Computed cache ----------------
+
+TEST(ComputedCacheTest, OverwritesOnCollision) {
+    ComputedCache cache(1);
+    BDD_ID result = 0;
+
+    cache.insert(0, 2, 4, 0, 6);
+    EXPECT_TRUE(cache.lookup(0, 2, 4, 0, result));
+    EXPECT_EQ(result, 6u);
+    EXPECT_FALSE(cache.lookup(1, 2, 4, 0, result));   // same operands, other operation
+
+    cache.insert(0, 4, 6, 0, 8);                  // single slot: evicts (2,4,0)
+    EXPECT_FALSE(cache.lookup(0, 2, 4, 0, result));
+    EXPECT_TRUE(cache.lookup(0, 4, 6, 0, result));
+    EXPECT_EQ(result, 8u);
+    EXPECT_EQ(cache.lookups, 4u);
+    EXPECT_EQ(cache.hits, 2u);
+}
+
+TEST(ComputedCacheTest, SizeIsPowerOfTwoAndAutoResizes) {
+    ComputedCache cache(100);
+    EXPECT_EQ(cache.size(), 128u);
+
+    cache.setAutoResize(true, 256, 0.5);
+    BDD_ID result = 0;
+    for (BDD_ID k = 0; k < 128; ++k) {
+        cache.insert(0, k, k, k, k);
+        cache.lookup(0, k, k, k, result);         // every lookup after insert hits
+    }
+    EXPECT_EQ(cache.size(), 256u);
+}
+
+TEST(ManagerBasicTest, TinyComputedCacheGivesSameResults) {
+    Manager small, large;
+    small.setComputedCacheSize(1);
+    small.setComputedCacheAutoResize(false);
+    EXPECT_EQ(small.computedCacheSize(), 1u);
+
+    std::vector<BDD_ID> vs, vl;
+    for (int i = 0; i < 6; ++i) {
+        vs.push_back(small.createVar("v" + std::to_string(i)));
+        vl.push_back(large.createVar("v" + std::to_string(i)));
+    }
+    BDD_ID fs = small.False(), fl = large.False();
+    for (int i = 0; i + 1 < 6; ++i) {
+        fs = small.xor2(fs, small.and2(vs[i], small.or2(vs[i + 1], fs)));
+        fl = large.xor2(fl, large.and2(vl[i], large.or2(vl[i + 1], fl)));
+    }
+    EXPECT_EQ(fs, fl);
+    EXPECT_EQ(small.uniqueTableSize(), large.uniqueTableSize());
+}
+
+// ---------------- Garbage collection ----------------
+
+TEST_F(ManagerTest, CollectGarbageKeepsRegisteredRoots) {
+    BDD_ID f = manager.and2(manager.or2(a, b), c);
+    manager.registerRoot(f);
+    BDD_ID g = manager.xor2(c, d);
+    (void)g;
+    size_t before = manager.uniqueTableSize();
+
+    EXPECT_GT(manager.collectGarbage(), 0u);
+    EXPECT_LT(manager.uniqueTableSize(), before);
+
+    // f is still intact and canonical
+    EXPECT_EQ(manager.and2(manager.or2(a, b), c), f);
+    EXPECT_EQ(manager.coFactorFalse(f, c), manager.False());
+}
+
+TEST_F(ManagerTest, CollectGarbageExplicitRoots) {
+    BDD_ID f = manager.or2(a, manager.and2(b, c));
+    size_t before = manager.uniqueTableSize();
+
+    EXPECT_EQ(manager.collectGarbage({f}), 0u);
+    EXPECT_EQ(manager.uniqueTableSize(), before);
+
+    EXPECT_GT(manager.collectGarbage(), 0u);
+    EXPECT_EQ(manager.uniqueTableSize(), 5u);   // terminal and the four variables
+}
+
+TEST_F(ManagerTest, CollectGarbageReusesFreedSlots) {
+    manager.xor2(a, manager.and2(b, c));
+    manager.collectGarbage();
+    size_t live = manager.uniqueTableSize();
+
+    BDD_ID f = manager.and2(a, b);
+    EXPECT_EQ(manager.uniqueTableSize(), live + 1);
+    EXPECT_EQ(manager.coFactorTrue(f, a), b);
+    EXPECT_EQ(manager.coFactorFalse(f, a), manager.False());
+}
+
+TEST_F(ManagerTest, CollectGarbageAndCompactRemapsIds) {
+    manager.xor2(a, b);                              // garbage below f
+    BDD_ID f = manager.or2(manager.and2(c, d), a);
+    BDD_ID g = manager.neg(manager.and2(b, d));
+    manager.registerRoot(g);
+
+    IdRemap remap = manager.collectGarbageAndCompact({f});
+    BDD_ID nf = remap(f);
+    BDD_ID ng = remap(g);
+    BDD_ID na = remap(a), nb = remap(b), nc = remap(c), nd = remap(d);
+
+    EXPECT_EQ(manager.uniqueTableSize(), 8u);   // terminal, 4 variables, f needs 2, g needs 1
+    EXPECT_EQ(manager.or2(manager.and2(nc, nd), na), nf);
+    EXPECT_EQ(manager.nand2(nb, nd), ng);
+    EXPECT_EQ(manager.uniqueTableSize(), 8u);
+
+    // registered roots follow the compaction
+    EXPECT_EQ(manager.collectGarbage(), 2u);    // only f and c & d are dropped
+}
+
+// ---------------- Resource limits ----------------
+
+TEST_F(ManagerTest, NodeLimitAndAbortFlagInterruptOperations) {
+    manager.setNodeLimit(manager.uniqueTableSize());
+    EXPECT_THROW(manager.and2(a, b), std::runtime_error);
+    EXPECT_EQ(manager.and2(a, manager.True()), a);          // no node needed
+
+    manager.setNodeLimit(0);
+    std::atomic<bool> abort{true};
+    manager.setAbortFlag(&abort);
+    EXPECT_THROW(manager.xor2(c, d), std::runtime_error);
+
+    abort = false;
+    BDD_ID f = manager.xor2(c, d);
+    EXPECT_EQ(manager.coFactorTrue(f, c), manager.neg(d));
+}
+
+// ---------------- Dynamic reordering ----------------
+
+class ReorderTest : public ::testing::Test {
+protected:
+    Manager manager;
+    std::vector<BDD_ID> xs, ys;
+
+    // x1 y1 + x2 y2 + ... with all x above all y: exponential in n.
+    // The result is a registered root, so it survives automatic reordering.
+    BDD_ID buildPairs(size_t n) {
+        for (size_t k = 0; k < n; ++k) xs.push_back(manager.createVar("x" + std::to_string(k)));
+        for (size_t k = 0; k < n; ++k) ys.push_back(manager.createVar("y" + std::to_string(k)));
+        BDD_ID f = manager.False();
+        for (size_t k = 0; k < n; ++k) {
+            BDD_ID term = manager.and2(xs[k], ys[k]);
+            BDD_ID next = manager.or2(f, term);
+            manager.registerRoot(next);
+            manager.unregisterRoot(f);
+            f = next;
+        }
+        return f;
+    }
+
+    std::vector<bool> truthTable(BDD_ID f) {
+        std::vector<BDD_ID> vars(xs);
+        vars.insert(vars.end(), ys.begin(), ys.end());
+        std::vector<bool> table;
+        for (size_t m = 0; m < (size_t(1) << vars.size()); ++m) {
+            BDD_ID r = f;
+            for (size_t k = 0; k < vars.size(); ++k) {
+                r = (m >> k) & 1 ? manager.coFactorTrue(r, vars[k]) : manager.coFactorFalse(r, vars[k]);
+            }
+            table.push_back(r == manager.True());
+        }
+        return table;
+    }
+};
+
+TEST_F(ReorderTest, SiftingShrinksBadOrderAndKeepsFunctions) {
+    BDD_ID f = buildPairs(5);
+    BDD_ID g = manager.xor2(xs[0], manager.neg(ys[4]));
+    std::vector<bool> fTable = truthTable(f), gTable = truthTable(g);
+
+    manager.collectGarbage({g});
+    size_t before = manager.uniqueTableSize();
+    size_t after = manager.reorder({g});
+    EXPECT_LT(after, before);
+    EXPECT_EQ(manager.getReorderStats().runs, 1u);
+    EXPECT_EQ(manager.getReorderStats().nodesBefore, before);
+    EXPECT_EQ(manager.getReorderStats().nodesAfter, after);
+
+    // IDs survive reordering and still denote the same functions
+    EXPECT_EQ(truthTable(f), fTable);
+    EXPECT_EQ(truthTable(g), gTable);
+    for (size_t k = 0; k < xs.size(); ++k) {
+        EXPECT_TRUE(manager.isVariable(xs[k]));
+        EXPECT_EQ(manager.getTopVarName(xs[k]), "x" + std::to_string(k));
+        EXPECT_EQ(manager.and2(xs[k], ys[k]), manager.and2(ys[k], xs[k]));
+    }
+
+    // the unique table is still canonical: rebuilding finds the same nodes
+    BDD_ID rebuilt = manager.False();
+    for (size_t k = 0; k < xs.size(); ++k) rebuilt = manager.or2(rebuilt, manager.and2(xs[k], ys[k]));
+    EXPECT_EQ(rebuilt, f);
+
+    // pairs end up adjacent: the result is linear in n
+    for (size_t k = 0; k < xs.size(); ++k) {
+        size_t distance = manager.getLevel(xs[k]) > manager.getLevel(ys[k])
+                          ? manager.getLevel(xs[k]) - manager.getLevel(ys[k])
+                          : manager.getLevel(ys[k]) - manager.getLevel(xs[k]);
+        EXPECT_EQ(distance, 1u);
+    }
+}
+
+TEST_F(ReorderTest, TopVariableFollowsOrder) {
+    BDD_ID f = buildPairs(3);
+    EXPECT_EQ(manager.topVar(f), xs[0]);
+    manager.reorder();
+    BDD_ID top = manager.topVar(f);
+    EXPECT_EQ(manager.getLevel(top), 0u);
+    EXPECT_EQ(manager.getLevel(f), 0u);
+    EXPECT_EQ(manager.getLevel(manager.True()), 6u);
+}
+
+TEST_F(ReorderTest, AutoReorderTriggersOnGrowth) {
+    manager.setAutoReorder(true, 32);
+    BDD_ID f = buildPairs(6);
+    EXPECT_GE(manager.getReorderStats().runs, 1u);
+
+    std::vector<bool> table = truthTable(f);
+    for (size_t m = 0; m < table.size(); ++m) {
+        bool expected = false;
+        for (size_t k = 0; k < 6; ++k) expected = expected || (((m >> k) & (m >> (k + 6)) & 1) != 0);
+        ASSERT_EQ(table[m], expected) << "minterm " << m;
+    }
+}
+
+TEST_F(ReorderTest, ExportedOrderFollowsLevels) {
+    buildPairs(3);
+    EXPECT_EQ(manager.getVariableOrder(), (std::vector<std::string>{"x0", "x1", "x2", "y0", "y1", "y2"}));
+    manager.reorder();
+
+    std::vector<std::string> order = manager.getVariableOrder();
+    ASSERT_EQ(order.size(), 6u);
+    for (size_t level = 0; level < order.size(); ++level) {
+        BDD_ID var = order[level][0] == 'x' ? xs[order[level][1] - '0'] : ys[order[level][1] - '0'];
+        EXPECT_EQ(manager.getLevel(var), level);
+    }
+
+    std::string path = "variable_order_test.txt";
+    manager.exportVariableOrder(path);
+    std::ifstream in(path);
+    std::string line;
+    std::vector<std::string> read;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[0] != '#') read.push_back(line);
+    }
+    EXPECT_EQ(read, order);
+}
+
+TEST_F(ReorderTest, CompactionAfterReorderPutsChildrenFirst) {
+    BDD_ID f = buildPairs(4);
+    manager.reorder();
+    IdRemap remap = manager.collectGarbageAndCompact({});
+    f = remap(f);
+
+    std::set<BDD_ID> nodes;
+    manager.findNodes(f, nodes);
+    for (BDD_ID n : nodes) {
+        if (manager.isConstant(n)) continue;
+        EXPECT_LT(manager.coFactorTrue(n) >> 1, n >> 1);
+        EXPECT_LT(manager.coFactorFalse(n) >> 1, n >> 1);
+    }
+    EXPECT_EQ(*nodes.rbegin() >> 1, f >> 1);
+}
+
+// ---------------- Node store ----------------
+
+TEST(NodeStoreTest, SlotsKeepTheirAddressWhileGrowing) {
+    using Node = BasicBDDNode<uint32_t>;
+    NodeStore<Node> store(Node(0, 0, 7));
+    store.push_back(Node(1, 2, 3));
+    Node *first = &store[0];
+
+    const size_t count = 3 * NodeStore<Node>::PAGE_SIZE + 5;
+    for (size_t i = 1; i < count; ++i) EXPECT_EQ(store.allocate(), i);
+    EXPECT_EQ(store.size(), count);
+    EXPECT_EQ(&store[0], first);
+    EXPECT_EQ(first->low, 2u);
+    EXPECT_EQ(store[count - 1].level, 7u);          // new slots hold the fill node
+    EXPECT_GE(store.reservedBytes(), count * sizeof(Node));
+
+    NodeStore<Node> other(Node(0, 0, 9));
+    other.push_back(Node(4, 5, 6));
+    store.swap(other);
+    EXPECT_EQ(store.size(), 1u);
+    EXPECT_EQ(&other[0], first);
+    EXPECT_EQ(store[store.allocate()].level, 9u);
+}
+
+// ---------------- Parallel apply ----------------
+
+class ParallelApplyTest : public ::testing::Test {
+protected:
+    Manager serial, parallel;
+
+    // Ripple-carry adder outputs plus x0 y0 + ... + x11 y11 with all x above all y
+    static std::vector<BDD_ID> build(Manager &m) {
+        std::vector<BDD_ID> xs, ys;
+        createVars(m, xs, ys);
+        return combine(m, xs, ys);
+    }
+
+    static void createVars(Manager &m, std::vector<BDD_ID> &xs, std::vector<BDD_ID> &ys) {
+        for (size_t k = 0; k < 12; ++k) xs.push_back(m.createVar("x" + std::to_string(k)));
+        for (size_t k = 0; k < 12; ++k) ys.push_back(m.createVar("y" + std::to_string(k)));
+    }
+
+    static std::vector<BDD_ID> combine(Manager &m, const std::vector<BDD_ID> &xs, const std::vector<BDD_ID> &ys) {
+        std::vector<BDD_ID> outputs;
+        BDD_ID carry = m.False(), pairs = m.False();
+        for (size_t k = 0; k < 12; ++k) {
+            outputs.push_back(m.xor2(m.xor2(xs[k], ys[k]), carry));
+            carry = m.or2(m.and2(xs[k], ys[k]), m.and2(carry, m.or2(xs[k], ys[k])));
+            pairs = m.or2(pairs, m.and2(xs[k], ys[k]));
+        }
+        outputs.push_back(carry);
+        outputs.push_back(pairs);
+        outputs.push_back(m.ite(xs[3], pairs, m.neg(carry)));
+        outputs.push_back(m.coFactorFalse(pairs, xs[0]));
+        return outputs;
+    }
+
+    // Same variable order in both managers: canonical BDDs are isomorphic
+    bool isomorphic(BDD_ID f, BDD_ID g, std::map<BDD_ID, BDD_ID> &seen) {
+        if (serial.isConstant(f) || parallel.isConstant(g)) {
+            return (f == serial.True()) == (g == parallel.True()) && serial.isConstant(f) == parallel.isConstant(g);
+        }
+        auto it = seen.find(f);
+        if (it != seen.end()) return it->second == g;
+        seen.emplace(f, g);
+        return serial.getTopVarName(f) == parallel.getTopVarName(g) &&
+               isomorphic(serial.coFactorTrue(f), parallel.coFactorTrue(g), seen) &&
+               isomorphic(serial.coFactorFalse(f), parallel.coFactorFalse(g), seen);
+    }
+};
+
+TEST_F(ParallelApplyTest, MatchesSerialEngine) {
+    parallel.setThreadCount(4);
+    EXPECT_EQ(parallel.getThreadCount(), 4u);
+    EXPECT_EQ(serial.getThreadCount(), 1u);
+
+    std::vector<BDD_ID> expected = build(serial), actual = build(parallel);
+    ASSERT_EQ(expected.size(), actual.size());
+    std::map<BDD_ID, BDD_ID> seen;
+    for (size_t k = 0; k < expected.size(); ++k) {
+        EXPECT_TRUE(isomorphic(expected[k], actual[k], seen)) << "output " << k;
+    }
+    // no node is created twice, even when workers race for it
+    EXPECT_EQ(parallel.uniqueTableSize(), serial.uniqueTableSize());
+    EXPECT_GT(parallel.computedCacheLookups(), 0u);
+
+    // back to the serial engine on the same tables
+    parallel.setThreadCount(1);
+    EXPECT_EQ(parallel.or2(actual[13], actual[12]), parallel.neg(parallel.and2(parallel.neg(actual[12]),
+                                                                                parallel.neg(actual[13]))));
+    EXPECT_EQ(parallel.xor2(actual[0], actual[0]), parallel.False());
+}
+
+TEST_F(ParallelApplyTest, AbortFlagStopsAllWorkers) {
+    parallel.setThreadCount(3);
+    BDD_ID a = parallel.createVar("a"), b = parallel.createVar("b");
+    std::atomic<bool> abort{true};
+    parallel.setAbortFlag(&abort);
+    EXPECT_THROW(parallel.xor2(a, b), std::runtime_error);
+
+    abort = false;
+    BDD_ID f = parallel.xor2(a, b);
+    EXPECT_EQ(parallel.coFactorTrue(f, a), parallel.neg(b));
+    EXPECT_EQ(parallel.uniqueTableSize(), 4u);
+}
+
+TEST_F(ParallelApplyTest, RunsReuseCollectedSlots) {
+    std::vector<BDD_ID> xs, ys;
+    createVars(parallel, xs, ys);
+    // built serially, so the store ends right after the live nodes
+    combine(parallel, xs, ys);
+    combine(parallel, std::vector<BDD_ID>(xs.rbegin(), xs.rend()), ys);
+    const size_t end = parallel.uniqueTableSize();
+    parallel.collectGarbage();
+
+    parallel.setThreadCount(4);
+    std::vector<BDD_ID> actual = combine(parallel, xs, ys), expected = build(serial);
+    std::map<BDD_ID, BDD_ID> seen;
+    std::set<BDD_ID> visited;
+    std::function<void(BDD_ID)> checkSlots = [&](BDD_ID f) {
+        f &= ~static_cast<BDD_ID>(1);      // the regular node
+        if (parallel.isConstant(f) || !visited.insert(f).second) return;
+        EXPECT_LT(f >> 1, end) << "node " << f;
+        checkSlots(parallel.coFactorTrue(f));
+        checkSlots(parallel.coFactorFalse(f));
+    };
+    for (size_t k = 0; k < expected.size(); ++k) {
+        EXPECT_TRUE(isomorphic(expected[k], actual[k], seen)) << "output " << k;
+        checkSlots(actual[k]);
+    }
+    EXPECT_EQ(parallel.collectGarbage(actual), serial.collectGarbage(expected));
+}
+
+TEST_F(ParallelApplyTest, ThreadSafeClientsShareTheManager) {
+    std::vector<BDD_ID> xs, ys;
+    parallel.setThreadSafe(true, 24);
+    EXPECT_TRUE(parallel.isThreadSafe());
+    createVars(parallel, xs, ys);
+
+    std::vector<std::vector<BDD_ID>> results(4);
+    std::vector<std::thread> clients;
+    for (size_t t = 0; t < results.size(); ++t) {
+        clients.emplace_back([&, t]() { results[t] = combine(parallel, xs, ys); });
+    }
+    for (auto &client : clients) client.join();
+
+    std::vector<BDD_ID> expected = build(serial);
+    std::map<BDD_ID, BDD_ID> seen;
+    for (size_t k = 0; k < expected.size(); ++k) {
+        EXPECT_TRUE(isomorphic(expected[k], results[0][k], seen)) << "output " << k;
+    }
+    // canonical: every client got the very same nodes
+    for (size_t t = 1; t < results.size(); ++t) EXPECT_EQ(results[t], results[0]);
+    EXPECT_THROW(parallel.createVar("z"), std::runtime_error);
+
+    parallel.setThreadSafe(false);
+    EXPECT_EQ(parallel.uniqueTableSize(), serial.uniqueTableSize());
+    EXPECT_EQ(parallel.collectGarbage(results[0]), serial.collectGarbage(expected));
+}
+
+// ---------------- Unique table growth ----------------
+
+class UniqueTableGrowthTest : public ParallelApplyTest {};
+
+TEST_F(UniqueTableGrowthTest, IncrementalRehashMatchesRehashAtOnce) {
+    serial.setUniqueTableGrowth(1.0, 16, 0);
+    parallel.setUniqueTableGrowth(0.5, 2, 1);       // grows often and drains slowly
+
+    std::vector<BDD_ID> expected = build(serial), actual = build(parallel);
+    std::map<BDD_ID, BDD_ID> seen;
+    for (size_t k = 0; k < expected.size(); ++k) {
+        EXPECT_TRUE(isomorphic(expected[k], actual[k], seen)) << "output " << k;
+    }
+    EXPECT_EQ(parallel.uniqueTableSize(), serial.uniqueTableSize());
+
+    // nodes on chains that were not drained yet are found and removed
+    EXPECT_EQ(parallel.collectGarbage({actual[12], actual[13]}), serial.collectGarbage({expected[12], expected[13]}));
+    EXPECT_EQ(parallel.or2(actual[12], actual[13]), parallel.neg(parallel.and2(parallel.neg(actual[12]),
+                                                                                parallel.neg(actual[13]))));
+    size_t size = parallel.uniqueTableSize();
+    EXPECT_EQ(parallel.and2(actual[13], actual[12]), parallel.and2(actual[12], actual[13]));
+    EXPECT_EQ(parallel.uniqueTableSize(), size);
+    EXPECT_THROW(parallel.setUniqueTableGrowth(0), std::invalid_argument);
+}
+
+// ---------------- Breadth-first apply ----------------
+
+class BreadthFirstApplyTest : public ParallelApplyTest {};
+
+TEST_F(BreadthFirstApplyTest, MatchesDepthFirstEngine) {
+    parallel.setBreadthFirst(true);
+    EXPECT_TRUE(parallel.isBreadthFirst());
+    EXPECT_FALSE(serial.isBreadthFirst());
+
+    std::vector<BDD_ID> expected = build(serial), actual = build(parallel);
+    std::map<BDD_ID, BDD_ID> seen;
+    for (size_t k = 0; k < expected.size(); ++k) {
+        EXPECT_TRUE(isomorphic(expected[k], actual[k], seen)) << "output " << k;
+    }
+    // shared sub-calls become one request, so no node is created twice
+    EXPECT_EQ(parallel.uniqueTableSize(), serial.uniqueTableSize());
+
+    // back to the depth-first engine on the same tables
+    parallel.setBreadthFirst(false);
+    size_t size = parallel.uniqueTableSize();
+    EXPECT_EQ(parallel.coFactorFalse(actual[13], parallel.topVar(actual[0])), actual[15]);
+    EXPECT_EQ(parallel.uniqueTableSize(), size);
+}
+
+// ---------------- Quantification ----------------
+
+TEST_F(ManagerTest, ExistsAndForallMatchCofactors) {
+    BDD_ID f = manager.or2(manager.and2(a, b), manager.and2(manager.neg(a), manager.xor2(c, d)));
+    EXPECT_EQ(manager.exists(f, a), manager.or2(manager.coFactorTrue(f, a), manager.coFactorFalse(f, a)));
+    EXPECT_EQ(manager.forall(f, a), manager.and2(manager.coFactorTrue(f, a), manager.coFactorFalse(f, a)));
+
+    BDD_ID ac = manager.and2(a, c);
+    BDD_ID expected = manager.exists(manager.exists(f, c), a);
+    EXPECT_EQ(manager.exists(f, ac), expected);
+    EXPECT_EQ(manager.exists(manager.neg(f), ac), manager.neg(manager.forall(f, ac)));
+    EXPECT_EQ(manager.exists(f, manager.True()), f);
+    EXPECT_EQ(manager.exists(f, manager.and2(ac, manager.and2(b, d))), manager.True());
+    EXPECT_EQ(manager.forall(manager.and2(b, c), manager.and2(a, d)), manager.and2(b, c));
+
+    EXPECT_THROW(manager.exists(f, manager.or2(a, c)), std::invalid_argument);
+    EXPECT_THROW(manager.forall(f, manager.neg(a)), std::invalid_argument);
+}
+
+TEST_F(ManagerTest, AndExistsMatchesConjunctionThenExists) {
+    BDD_ID f = manager.or2(manager.and2(a, manager.neg(c)), manager.xor2(b, d));
+    BDD_ID g = manager.ite(c, manager.neg(a), manager.and2(b, d));
+    std::vector<BDD_ID> cubes = {manager.True(), a, manager.and2(a, c), manager.and2(b, d),
+                                 manager.and2(manager.and2(a, b), manager.and2(c, d))};
+    for (BDD_ID cube : cubes) {
+        EXPECT_EQ(manager.andExists(f, g, cube), manager.exists(manager.and2(f, g), cube));
+        EXPECT_EQ(manager.andExists(manager.neg(f), g, cube), manager.exists(manager.and2(manager.neg(f), g), cube));
+        EXPECT_EQ(manager.andExists(g, f, cube), manager.andExists(f, g, cube));
+    }
+    EXPECT_EQ(manager.andExists(f, manager.neg(f), a), manager.False());
+    EXPECT_EQ(manager.andExists(f, manager.True(), c), manager.exists(f, c));
+    EXPECT_THROW(manager.andExists(f, g, manager.xor2(a, b)), std::invalid_argument);
+}
+
+TEST_F(ParallelApplyTest, QuantificationMatchesSerialEngine) {
+    parallel.setThreadCount(3);
+    std::vector<BDD_ID> serialXs, serialYs, parallelXs, parallelYs;
+    createVars(serial, serialXs, serialYs);
+    createVars(parallel, parallelXs, parallelYs);
+    std::vector<BDD_ID> expected = combine(serial, serialXs, serialYs);
+    std::vector<BDD_ID> actual = combine(parallel, parallelXs, parallelYs);
+
+    // every other x and the low half of the y
+    auto cube = [](Manager &m, const std::vector<BDD_ID> &xs, const std::vector<BDD_ID> &ys) {
+        BDD_ID result = m.True();
+        for (size_t k = 0; k < 12; k += 2) result = m.and2(result, xs[k]);
+        for (size_t k = 0; k < 6; ++k) result = m.and2(result, ys[k]);
+        return result;
+    };
+    BDD_ID serialCube = cube(serial, serialXs, serialYs), parallelCube = cube(parallel, parallelXs, parallelYs);
+
+    std::map<BDD_ID, BDD_ID> seen;
+    for (size_t k = 0; k + 1 < expected.size(); ++k) {
+        EXPECT_TRUE(isomorphic(serial.exists(expected[k], serialCube),
+                               parallel.exists(actual[k], parallelCube), seen)) << "exists " << k;
+        EXPECT_TRUE(isomorphic(serial.forall(expected[k], serialCube),
+                               parallel.forall(actual[k], parallelCube), seen)) << "forall " << k;
+        EXPECT_TRUE(isomorphic(serial.andExists(expected[k], expected[k + 1], serialCube),
+                               parallel.andExists(actual[k], actual[k + 1], parallelCube), seen)) << "andExists " << k;
+    }
+    EXPECT_EQ(parallel.andExists(actual[12], actual[13], parallelCube),
+              parallel.exists(parallel.and2(actual[12], actual[13]), parallelCube));
+}
+
+// ---------------- Substitution ----------------
+
+TEST_F(ManagerTest, PermuteRenamesVariables) {
+    BDD_ID f = manager.or2(manager.and2(a, manager.neg(b)), c);
+    EXPECT_EQ(manager.permute(f, {{a, b}, {b, a}}), manager.or2(manager.and2(b, manager.neg(a)), c));
+    // moves a below every other variable of f
+    EXPECT_EQ(manager.permute(f, {{a, d}}), manager.or2(manager.and2(d, manager.neg(b)), c));
+    EXPECT_EQ(manager.permute(manager.neg(f), {{c, d}}), manager.neg(manager.or2(manager.and2(a, manager.neg(b)), d)));
+    EXPECT_EQ(manager.permute(f, {{d, a}}), f);
+    EXPECT_EQ(manager.permute(f, {}), f);
+    EXPECT_EQ(manager.permute(manager.True(), {{a, b}}), manager.True());
+
+    EXPECT_THROW(manager.permute(f, {{a, manager.neg(b)}}), std::invalid_argument);
+    EXPECT_THROW(manager.permute(f, {{manager.and2(a, b), c}}), std::invalid_argument);
+}
+
+TEST_F(ManagerTest, ComposeMatchesCofactors) {
+    BDD_ID f = manager.ite(a, manager.xor2(b, d), manager.and2(b, c));
+    BDD_ID g = manager.or2(manager.neg(c), d);
+    EXPECT_EQ(manager.compose(f, b, g), manager.ite(g, manager.coFactorTrue(f, b), manager.coFactorFalse(f, b)));
+    EXPECT_EQ(manager.compose(f, a, g), manager.ite(g, manager.coFactorTrue(f, a), manager.coFactorFalse(f, a)));
+    EXPECT_EQ(manager.compose(manager.neg(f), d, manager.True()), manager.neg(manager.coFactorTrue(f, d)));
+    EXPECT_EQ(manager.compose(f, b, b), f);
+
+    // all variables are replaced at once, not one after the other
+    BDD_ID h = manager.xor2(a, manager.and2(b, c));
+    EXPECT_EQ(manager.vectorCompose(h, {{a, b}, {b, manager.neg(a)}}),
+              manager.xor2(b, manager.and2(manager.neg(a), c)));
+    EXPECT_EQ(manager.vectorCompose(h, {{a, c}, {c, d}}), manager.permute(h, {{a, c}, {c, d}}));
+    EXPECT_THROW(manager.compose(f, manager.neg(a), g), std::invalid_argument);
+}
+
+TEST_F(ManagerTest, RepeatedSubstitutionHitsTheCache) {
+    BDD_ID f = manager.or2(manager.and2(a, b), manager.and2(c, d));
+    BDD_ID renamed = manager.permute(f, {{a, c}, {c, a}});
+    size_t size = manager.uniqueTableSize();
+    size_t hits = manager.computedCacheHits();
+    EXPECT_EQ(manager.permute(f, {{c, a}, {a, c}}), renamed);
+    EXPECT_EQ(manager.computedCacheHits(), hits + 1);
+    EXPECT_EQ(manager.uniqueTableSize(), size);
+
+    // the substitution keeps its function alive, also through a compaction
+    BDD_ID g = manager.xor2(b, d);
+    BDD_ID composed = manager.vectorCompose(f, {{a, g}, {d, c}});
+    manager.collectGarbage({f, composed});
+    EXPECT_EQ(manager.vectorCompose(f, {{a, g}, {d, c}}), composed);
+    IdRemap remap = manager.collectGarbageAndCompact({f, composed});
+    f = remap(f);
+    g = remap(g);
+    EXPECT_EQ(manager.vectorCompose(f, {{a, g}, {d, c}}), remap(composed));
+    EXPECT_EQ(remap(composed), manager.or2(manager.and2(g, b), c));
+}
+
+TEST(SubstitutionTest, ComposeSurvivesAutoReorder) {
+    Manager manager;
+    std::vector<BDD_ID> vars;
+    for (int k = 0; k < 8; ++k) vars.push_back(manager.createVar("v" + std::to_string(k)));
+    BDD_ID f = manager.True(), g = manager.False();
+    for (int k = 0; k < 4; ++k) {
+        f = manager.and2(f, manager.xor2(vars[k], vars[7 - k]));
+        g = manager.or2(g, manager.and2(vars[2 * k], vars[2 * k + 1]));
+    }
+    const BDD_ID x = vars[3];
+    // the cofactors of f must survive until the replacement is built
+    manager.setAutoReorder(true, manager.uniqueTableSize() + 1);
+    BDD_ID composed = manager.compose(f, x, g);
+    manager.setAutoReorder(false);
+
+    for (int bits = 0; bits < 256; ++bits) {
+        BDD_ID cube = manager.True(), replaced = manager.True();
+        for (int k = 0; k < 8; ++k) {
+            cube = manager.and2(cube, bits >> k & 1 ? vars[k] : manager.neg(vars[k]));
+        }
+        // the same assignment with x set to the value of g
+        const bool gValue = manager.and2(cube, g) != manager.False();
+        for (int k = 0; k < 8; ++k) {
+            const bool value = vars[k] == x ? gValue : (bits >> k & 1) != 0;
+            replaced = manager.and2(replaced, value ? vars[k] : manager.neg(vars[k]));
+        }
+        EXPECT_EQ(manager.and2(cube, composed) != manager.False(),
+                  manager.and2(replaced, f) != manager.False()) << "assignment " << bits;
+    }
+}
+
+TEST(SubstitutionTest, SwapIsLinearInAnInterleavedAdder) {
+    Manager manager;
+    std::vector<BDD_ID> xs, ys;
+    for (size_t k = 0; k < 128; ++k) {
+        xs.push_back(manager.createVar("x" + std::to_string(k)));
+        ys.push_back(manager.createVar("y" + std::to_string(k)));
+    }
+    BDD_ID carry = manager.False();
+    std::map<BDD_ID, BDD_ID> swap;
+    for (size_t k = 0; k < xs.size(); ++k) {
+        carry = manager.or2(manager.and2(xs[k], ys[k]), manager.and2(carry, manager.or2(xs[k], ys[k])));
+        swap[xs[k]] = ys[k];
+        swap[ys[k]] = xs[k];
+    }
+    // the carry is symmetric in each pair; every level is visited once, and a
+    // swapped pair costs a bounded number of ite calls
+    const size_t lookups = manager.computedCacheLookups(), size = manager.uniqueTableSize();
+    EXPECT_EQ(manager.permute(carry, swap), carry);
+    EXPECT_LT(manager.computedCacheLookups() - lookups, 16 * xs.size());
+    EXPECT_LE(manager.uniqueTableSize() - size, xs.size());
+}
+
+TEST_F(ParallelApplyTest, SubstitutionMatchesSerialEngine) {
+    parallel.setThreadCount(3);
+    std::vector<BDD_ID> serialXs, serialYs, parallelXs, parallelYs;
+    createVars(serial, serialXs, serialYs);
+    createVars(parallel, parallelXs, parallelYs);
+    std::vector<BDD_ID> expected = combine(serial, serialXs, serialYs);
+    std::vector<BDD_ID> actual = combine(parallel, parallelXs, parallelYs);
+
+    // swaps every x with its y
+    auto swap = [](const std::vector<BDD_ID> &xs, const std::vector<BDD_ID> &ys) {
+        std::map<BDD_ID, BDD_ID> mapping;
+        for (size_t k = 0; k < ys.size(); ++k) {
+            mapping[xs[k]] = ys[k];
+            mapping[ys[k]] = xs[k];
+        }
+        return mapping;
+    };
+    std::map<BDD_ID, BDD_ID> serialSwap = swap(serialXs, serialYs), parallelSwap = swap(parallelXs, parallelYs);
+
+    std::map<BDD_ID, BDD_ID> seen;
+    for (size_t k = 0; k + 1 < expected.size(); ++k) {
+        EXPECT_TRUE(isomorphic(serial.permute(expected[k], serialSwap),
+                               parallel.permute(actual[k], parallelSwap), seen)) << "permute " << k;
+        EXPECT_TRUE(isomorphic(serial.compose(expected[k], serialXs.back(), expected[k + 1]),
+                               parallel.compose(actual[k], parallelXs.back(), actual[k + 1]), seen)) << "compose " << k;
+        EXPECT_TRUE(isomorphic(serial.vectorCompose(expected[k], {{serialXs[0], expected[k + 1]},
+                                                                  {serialYs[1], serialXs[2]}}),
+                               parallel.vectorCompose(actual[k], {{parallelXs[0], actual[k + 1]},
+                                                                  {parallelYs[1], parallelXs[2]}}), seen))
+            << "vectorCompose " << k;
+    }
+}
+
+// ---------------- Generalized cofactors ----------------
+
+TEST_F(ManagerTest, ConstrainAndRestrictAgreeOnCareSet) {
+    BDD_ID f = manager.ite(a, manager.xor2(b, d), manager.and2(c, manager.neg(d)));
+    std::vector<BDD_ID> careSets = {manager.or2(a, c), manager.xor2(b, c), manager.and2(manager.neg(a), d),
+                                    manager.or2(manager.and2(a, b), manager.and2(c, d)), manager.neg(b)};
+    for (BDD_ID care : careSets) {
+        EXPECT_EQ(manager.and2(manager.constrain(f, care), care), manager.and2(f, care));
+        EXPECT_EQ(manager.and2(manager.restrict(f, care), care), manager.and2(f, care));
+        EXPECT_EQ(manager.constrain(manager.neg(f), care), manager.neg(manager.constrain(f, care)));
+        EXPECT_EQ(manager.restrict(manager.neg(f), care), manager.neg(manager.restrict(f, care)));
+    }
+
+    // a cube care set is a cofactor
+    EXPECT_EQ(manager.constrain(f, manager.and2(a, manager.neg(d))),
+              manager.coFactorFalse(manager.coFactorTrue(f, a), d));
+    EXPECT_EQ(manager.restrict(f, manager.neg(a)), manager.coFactorFalse(f, a));
+    EXPECT_EQ(manager.constrain(f, manager.True()), f);
+    EXPECT_EQ(manager.constrain(f, manager.False()), manager.False());
+    EXPECT_EQ(manager.restrict(f, f), manager.True());
+    EXPECT_EQ(manager.restrict(f, manager.neg(f)), manager.False());
+
+    // a care variable above f: constrain follows it, restrict drops it
+    BDD_ID g = manager.xor2(c, d);
+    BDD_ID care = manager.or2(manager.and2(a, c), manager.and2(manager.neg(a), d));
+    std::set<BDD_ID> vars;
+    manager.findVars(manager.constrain(g, care), vars);
+    EXPECT_EQ(vars.count(a), 1u);
+    vars.clear();
+    manager.findVars(manager.restrict(g, care), vars);
+    EXPECT_EQ(vars.count(a), 0u);
+    EXPECT_EQ(manager.restrict(g, care), manager.restrict(g, manager.or2(c, d)));
+}
+
+TEST_F(ManagerTest, MinimizeNeverGrows) {
+    BDD_ID f = manager.and2(manager.and2(a, b), manager.xor2(c, d));
+    EXPECT_EQ(manager.minimize(f, manager.and2(a, b)), manager.xor2(c, d));
+
+    // a care set spread over every variable must not make g larger
+    BDD_ID g = manager.and2(b, c);
+    BDD_ID care = manager.xor2(a, manager.xor2(b, manager.xor2(c, d)));
+    std::set<BDD_ID> before, after;
+    manager.findNodes(g, before);
+    manager.findNodes(manager.minimize(g, care), after);
+    EXPECT_LE(after.size(), before.size());
+    EXPECT_EQ(manager.and2(manager.minimize(g, care), care), manager.and2(g, care));
+
+    // the second call is answered by the computed table
+    BDD_ID restricted = manager.restrict(f, manager.or2(a, c));
+    size_t size = manager.uniqueTableSize();
+    size_t hits = manager.computedCacheHits();
+    EXPECT_EQ(manager.restrict(f, manager.or2(a, c)), restricted);
+    EXPECT_GT(manager.computedCacheHits(), hits);
+    EXPECT_EQ(manager.uniqueTableSize(), size);
+}
+
+TEST(GeneralizedCofactorTest, RestrictSurvivesAutoReorder) {
+    Manager manager;
+    BDD_ID a1 = manager.createVar("a1"), a2 = manager.createVar("a2");
+    BDD_ID x = manager.createVar("x"), y = manager.createVar("y");
+    BDD_ID f = manager.and2(x, y);
+    BDD_ID care = manager.ite(a1, manager.ite(a2, x, y), manager.ite(a2, x, manager.neg(y)));
+    // the care variables above f are quantified by a nested call, which must not sift
+    manager.setAutoReorder(true, manager.uniqueTableSize() + 1);
+    BDD_ID restricted = manager.restrict(f, care);
+    manager.setAutoReorder(false);
+
+    for (int bits = 0; bits < 16; ++bits) {
+        std::vector<BDD_ID> literals = {a1, a2, x, y};
+        BDD_ID cube = manager.True();
+        for (int k = 0; k < 4; ++k) {
+            cube = manager.and2(cube, bits >> k & 1 ? literals[k] : manager.neg(literals[k]));
+        }
+        if (manager.and2(cube, care) != manager.False()) {
+            EXPECT_EQ(manager.and2(cube, restricted), manager.and2(cube, f)) << "assignment " << bits;
+        }
+    }
+    std::set<BDD_ID> vars;
+    manager.findVars(restricted, vars);
+    EXPECT_EQ(vars.count(a1) + vars.count(a2), 0u);
+}
+
+TEST_F(ParallelApplyTest, GeneralizedCofactorsMatchSerialEngine) {
+    parallel.setThreadCount(3);
+    std::vector<BDD_ID> expected = build(serial), actual = build(parallel);
+
+    std::map<BDD_ID, BDD_ID> seen;
+    for (size_t k = 0; k + 1 < expected.size(); ++k) {
+        EXPECT_TRUE(isomorphic(serial.constrain(expected[k], expected[k + 1]),
+                               parallel.constrain(actual[k], actual[k + 1]), seen)) << "constrain " << k;
+        EXPECT_TRUE(isomorphic(serial.restrict(expected[k], expected[k + 1]),
+                               parallel.restrict(actual[k], actual[k + 1]), seen)) << "restrict " << k;
+    }
+}
+
+// ---------------- Checks ----------------
+
+TEST_F(ManagerTest, ChecksMatchBuiltResults) {
+    BDD_ID f = manager.and2(manager.or2(a, c), manager.xor2(b, d));
+    BDD_ID g = manager.or2(manager.xor2(b, d), manager.and2(a, c));
+    BDD_ID h = manager.and2(manager.neg(a), manager.neg(c));
+    std::vector<BDD_ID> functions = {manager.True(), manager.False(), a, manager.neg(b), f, g, h,
+                                     manager.neg(f), manager.ite(b, c, d)};
+    for (BDD_ID x : functions) {
+        for (BDD_ID y : functions) {
+            EXPECT_EQ(manager.leq(x, y), manager.or2(manager.neg(x), y) == manager.True());
+            EXPECT_EQ(manager.isDisjoint(x, y), manager.and2(x, y) == manager.False());
+        }
+    }
+    EXPECT_TRUE(manager.leq(f, g));
+    EXPECT_FALSE(manager.leq(g, f));
+    EXPECT_TRUE(manager.isDisjoint(f, h));
+
+    EXPECT_EQ(manager.iteConstant(f, g, manager.False()), NON_CONSTANT);
+    EXPECT_EQ(manager.iteConstant(f, g, manager.True()), manager.True());
+    EXPECT_EQ(manager.iteConstant(h, manager.neg(f), manager.or2(a, c)), manager.True());
+    EXPECT_EQ(manager.iteConstant(f, h, manager.False()), manager.False());
+    EXPECT_EQ(manager.iteConstant(a, manager.True(), b), NON_CONSTANT);
+    EXPECT_EQ(manager.iteConstant(manager.True(), manager.False(), a), manager.False());
+}
+
+TEST_F(ManagerTest, ChecksBuildNoNodesAndUseTheirOwnCache) {
+    BDD_ID f = manager.and2(manager.and2(a, b), manager.or2(c, d));
+    BDD_ID g = manager.or2(manager.and2(a, c), manager.and2(b, d));
+    size_t size = manager.uniqueTableSize();
+    size_t computedLookups = manager.computedCacheLookups();
+
+    EXPECT_TRUE(manager.leq(f, g));
+    EXPECT_FALSE(manager.isDisjoint(f, g));
+    EXPECT_EQ(manager.iteConstant(f, g, manager.True()), manager.True());
+    EXPECT_EQ(manager.uniqueTableSize(), size);
+    EXPECT_EQ(manager.computedCacheLookups(), computedLookups);
+
+    size_t hits = manager.checkCacheHits();
+    EXPECT_TRUE(manager.leq(f, g));
+    EXPECT_GT(manager.checkCacheHits(), hits);
+
+    // cached answers follow the nodes through a compaction
+    IdRemap remap = manager.collectGarbageAndCompact({f, g});
+    EXPECT_TRUE(manager.leq(remap(f), remap(g)));
+    EXPECT_FALSE(manager.leq(remap(g), remap(f)));
+}
+
+TEST_F(ParallelApplyTest, ChecksInThreadSafeMode) {
+    std::vector<BDD_ID> expected = build(serial), actual = build(parallel);
+    parallel.setThreadSafe(true, 24);
+    size_t size = parallel.uniqueTableSize();
+
+    std::vector<std::vector<char>> answers(3);
+    std::vector<std::thread> clients;
+    for (size_t t = 0; t < answers.size(); ++t) {
+        clients.emplace_back([&, t]() {
+            for (BDD_ID f : actual) {
+                for (BDD_ID g : actual) answers[t].push_back(parallel.leq(f, g) + 2 * parallel.isDisjoint(f, g));
+            }
+        });
+    }
+    for (auto &client : clients) client.join();
+
+    std::vector<char> serialAnswers;
+    for (BDD_ID f : expected) {
+        for (BDD_ID g : expected) serialAnswers.push_back(serial.leq(f, g) + 2 * serial.isDisjoint(f, g));
+    }
+    for (const auto &clientAnswers : answers) EXPECT_EQ(clientAnswers, serialAnswers);
+    EXPECT_EQ(parallel.uniqueTableSize(), size);
+}
+
 TEST_F(ManagerTest, VisualizeBDDSmokeTest) {
     BDD_ID f = manager.and2(a, b);
 
@@ -277,5 +1255,189 @@ TEST_F(ManagerTest, VisualizeBDDSmokeTest) {
     EXPECT_TRUE(in.is_open());
 }
 
+// ---------------- Circuit input order ----------------
+
+// Variable order of a circuit built on a fresh manager
+class InputOrderTest : public ::testing::Test {
+protected:
+    // o1 = a + ~(c d), o2 = b d; e is read by no gate
+    static list_of_circuit_t circuit() {
+        return {{1, "a", INPUT_GATE_T, {}, {8}},
+                {2, "b", INPUT_GATE_T, {}, {10}},
+                {3, "c", INPUT_GATE_T, {}, {6}},
+                {4, "d", INPUT_GATE_T, {}, {6, 10}},
+                {5, "e", INPUT_GATE_T, {}, {}},
+                {6, "n1", AND_GATE_T, {3, 4}, {7}},
+                {7, "n2", NOT_GATE_T, {6}, {8}},
+                {8, "n3", OR_GATE_T, {1, 7}, {9}},
+                {9, "o1", OUTPUT_GATE_T, {8}, {}},
+                {10, "n4", AND_GATE_T, {2, 4}, {11}},
+                {11, "o2", OUTPUT_GATE_T, {10}, {}}};
+    }
+
+    static std::vector<std::string> build(const list_of_circuit_t &circuit, InputOrder order,
+                                          const std::string &orderFile = "") {
+        auto manager = std::make_shared<Manager>();
+        CircuitToBDD converter(manager);
+        converter.SetInputOrder(order);
+        if (!orderFile.empty()) converter.SetInputOrderFile(orderFile);
+        converter.BuildBDD(circuit);
+        return manager->getVariableOrder();
+    }
+
+    static std::vector<std::string> inputs(const list_of_circuit_t &circuit) {
+        std::vector<std::string> labels;
+        for (const auto &node : circuit) {
+            if (node.gate_type == INPUT_GATE_T) labels.push_back(node.label);
+        }
+        std::sort(labels.begin(), labels.end());
+        return labels;
+    }
+};
+
+TEST_F(InputOrderTest, HeuristicsOrderAKnownCircuit) {
+    EXPECT_EQ(build(circuit(), InputOrder::Topological), (std::vector<std::string>{"a", "b", "c", "d", "e"}));
+    // deepest output first, deepest fanin first: c d below n2, then a, then b of o2
+    EXPECT_EQ(build(circuit(), InputOrder::DepthFirst), (std::vector<std::string>{"c", "d", "a", "b", "e"}));
+    // weights d 3/4, a 1/2, b 1/2, c 1/4; e carries none and comes last
+    EXPECT_EQ(build(circuit(), InputOrder::FanoutWeight), (std::vector<std::string>{"d", "a", "b", "c", "e"}));
+}
+
+TEST_F(InputOrderTest, EveryHeuristicPlacesEveryInputOnce) {
+    BenchParser parser(std::string(VDS_BENCHMARK_DIR) + "/iscas89/s27.bench");
+    const list_of_circuit_t s27 = parser.GetSortedCircuit();
+    for (const list_of_circuit_t &c : {circuit(), s27}) {
+        for (InputOrder order : {InputOrder::Topological, InputOrder::DepthFirst, InputOrder::FanoutWeight}) {
+            std::vector<std::string> labels = build(c, order);
+            std::sort(labels.begin(), labels.end());
+            EXPECT_EQ(labels, inputs(c)) << "heuristic " << static_cast<int>(order);
+        }
+    }
+}
+
+TEST_F(InputOrderTest, OrderFileReloadsAnExportedOrder) {
+    const std::string path = "input_order_test.txt";
+    auto manager = std::make_shared<Manager>();
+    CircuitToBDD converter(manager);
+    converter.SetInputOrder(InputOrder::FanoutWeight);
+    converter.BuildBDD(circuit());
+    manager->exportVariableOrder(path);
+    EXPECT_EQ(build(circuit(), InputOrder::Topological, path), manager->getVariableOrder());
+
+    // listed inputs first, the rest by the heuristic; other labels are ignored
+    {
+        std::ofstream out(path);
+        out << "# partial order\n" << "e\n" << "n1\n" << "c\n" << "e\n";
+    }
+    EXPECT_EQ(build(circuit(), InputOrder::DepthFirst, path), (std::vector<std::string>{"e", "c", "d", "a", "b"}));
+    std::remove(path.c_str());
+    EXPECT_THROW(build(circuit(), InputOrder::Topological, path), std::runtime_error);
+}
+
+// ---------------- Reachability ----------------
+
+// Reachability of a checked-in benchmark circuit on a fresh manager
+class ReachabilityTest : public ::testing::Test {
+protected:
+    static std::unique_ptr<Reachability> load(const std::string &path, ReachMode mode = ReachMode::BreadthFirst,
+                                              size_t clusterSize = Reachability::DEFAULT_CLUSTER_SIZE) {
+        BenchParser parser(std::string(VDS_BENCHMARK_DIR) + "/" + path);
+        return std::unique_ptr<Reachability>(new Reachability(std::make_shared<Manager>(),
+                                                              parser.GetSortedCircuit(), mode, clusterSize));
+    }
+
+    static std::vector<bool> state(size_t bits, size_t value) {
+        std::vector<bool> result;
+        for (size_t k = bits; k-- > 0;) result.push_back((value >> k & 1) != 0);
+        return result;
+    }
+};
+
+TEST_F(ReachabilityTest, CountsReachableStates) {
+    auto s27 = load("iscas89/s27.bench");
+    EXPECT_TRUE(s27->Run());
+    EXPECT_EQ(s27->GetLatchLabels().size(), 3u);
+    EXPECT_EQ(s27->CountStates(), 6);
+    EXPECT_TRUE(s27->IsReachable({false, false, false}));
+    EXPECT_FALSE(s27->IsReachable({true, true, true}));
+    EXPECT_THROW(s27->IsReachable({false, false}), std::invalid_argument);
+    size_t reachable = 0;
+    for (size_t value = 0; value < 8; ++value) reachable += s27->IsReachable(state(3, value));
+    EXPECT_EQ(reachable, 6u);
+
+    auto counter8 = load("counters/counter8.bench");
+    EXPECT_TRUE(counter8->Run());
+    EXPECT_EQ(counter8->CountStates(), 256);
+
+    auto mod100 = load("counters/mod100.bench");
+    EXPECT_TRUE(mod100->Run());
+    EXPECT_EQ(mod100->CountStates(), 100);
+    reachable = 0;
+    for (size_t value = 0; value < 128; ++value) reachable += mod100->IsReachable(state(7, value));
+    EXPECT_EQ(reachable, 100u);
+}
+
+TEST_F(ReachabilityTest, StepLimitStopsBeforeFixedPoint) {
+    auto s27 = load("iscas89/s27.bench");
+    EXPECT_FALSE(s27->Run(1));
+    EXPECT_EQ(s27->GetSteps().size(), 1u);
+    EXPECT_EQ(s27->CountStates(), 5);
+
+    auto counter8 = load("counters/counter8.bench");
+    EXPECT_FALSE(counter8->Run(10));
+    EXPECT_EQ(counter8->GetSteps().size(), 10u);
+    EXPECT_EQ(counter8->CountStates(), 11);
+}
+
+TEST_F(ReachabilityTest, ClusteredImageMatchesMonolithic) {
+    auto clustered = load("iscas89/s27.bench", ReachMode::BreadthFirst, 1);
+    auto monolithic = load("iscas89/s27.bench", ReachMode::BreadthFirst, 0);
+    ASSERT_EQ(clustered->GetClusters().size(), 3u);
+    EXPECT_EQ(monolithic->GetClusters().size(), 1u);
+    // no variable is quantified twice
+    size_t quantified = 0;
+    for (const ReachCluster &cluster : clustered->GetClusters()) quantified += cluster.quantified;
+    EXPECT_LE(quantified, clustered->GetNumberOfInputs() + clustered->GetLatchLabels().size());
+
+    // one image per call: both relations give the same successors at every step
+    bool done = false;
+    for (size_t step = 0; !done; ++step) {
+        ASSERT_LT(step, 8u);
+        done = clustered->Run(1);
+        EXPECT_EQ(monolithic->Run(1), done);
+        // same variable order, so equal functions have equal node counts
+        EXPECT_EQ(clustered->GetSteps().back().image_nodes, monolithic->GetSteps().back().image_nodes);
+        for (size_t value = 0; value < 8; ++value) {
+            EXPECT_EQ(clustered->IsReachable(state(3, value)), monolithic->IsReachable(state(3, value)))
+                << "step " << step << " state " << value;
+        }
+    }
+    EXPECT_EQ(clustered->CountStates(), 6);
+}
+
+TEST_F(ReachabilityTest, SquaringMatchesBreadthFirst) {
+    for (const std::string path : {"iscas89/s27.bench", "counters/counter8.bench", "counters/mod100.bench"}) {
+        auto bfs = load(path, ReachMode::BreadthFirst);
+        auto squaring = load(path, ReachMode::IterativeSquaring);
+        EXPECT_TRUE(bfs->Run());
+        EXPECT_TRUE(squaring->Run());
+        EXPECT_EQ(squaring->GetMode(), ReachMode::IterativeSquaring);
+        EXPECT_EQ(squaring->CountStates(), bfs->CountStates()) << path;
+
+        const size_t bits = bfs->GetLatchLabels().size();
+        for (size_t value = 0; value < (size_t(1) << bits); ++value) {
+            EXPECT_EQ(squaring->IsReachable(state(bits, value)), bfs->IsReachable(state(bits, value)))
+                << path << " state " << value;
+        }
+    }
+
+    // the depth is covered in logarithmically many squarings
+    auto bfs = load("counters/counter8.bench", ReachMode::BreadthFirst);
+    auto squaring = load("counters/counter8.bench", ReachMode::IterativeSquaring);
+    bfs->Run();
+    squaring->Run();
+    EXPECT_EQ(bfs->GetSteps().size(), 256u);
+    EXPECT_EQ(squaring->GetSteps().size(), 9u);
+}
 
 #endif
\ No newline at end of file